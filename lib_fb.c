@@ -10,6 +10,8 @@
  * 
  */
 //-----------------------------------------------------------------------------
+/* memfd_create (memory backend) */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -26,6 +28,14 @@
 #include <linux/fb.h>
 #include <getopt.h>
 
+/* glyph 확장 SIMD kernel (실행시 CPU에 맞게 선택) */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "lib_fb.h"
 //-----------------------------------------------------------------------------
 // Fonts
@@ -39,23 +49,82 @@
 #include "fonts/FontAscii_8x16.h"
 
 
+//-----------------------------------------------------------------------------
+// Glyph cache (scale, color가 적용된 glyph pixel block)
+//-----------------------------------------------------------------------------
+/* 2^n (hash table size) */
+#define GLYPH_CACHE_COUNT       256
+/* 큰 배율의 glyph는 cache하지 않는다. (row 확장 후 복사로 충분히 빠름) */
+#define GLYPH_CACHE_BLOCK_MAX   (32 * 1024)
+/* ascii glyph는 hangul font와 관계없음 */
+#define GLYPH_FONT_ASCII        -1
+
+typedef struct glyph__t {
+    /* key : ascii code or utf16, font, scale, fg/bg native pixel */
+    __u32           code;
+    int             font, scale;
+    __u32           fg, bg;
+    /* pixel block (w * h * p_size, row 단위 연속) */
+    int             w, h, size;
+    unsigned char   *data;
+}   glyph_t;
+
+typedef struct glyph_cache__t {
+    glyph_t         slot[GLYPH_CACHE_COUNT];
+    __u32           hit, miss;
+}   glyph_cache_t;
+
 //-----------------------------------------------------------------------------
 // Function prototype define.
 //-----------------------------------------------------------------------------
 static void make_image  (unsigned char is_first,
                         unsigned char *dest,
-                        unsigned char *src);
-static unsigned char *get_hangul_image( unsigned char HAN1,
-                                        unsigned char HAN2,
-                                        unsigned char HAN3);
-static void draw_hangul_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
-                    int f_color, int b_color, int scale);
-static void draw_ascii_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
-                    int f_color, int b_color, int scale);
+                        const unsigned char *src);
+static void make_hangul_image (enum eFONTS_HANGUL font, unsigned short idx,
+                        unsigned char *dest);
+static unsigned short utf8_to_utf16 (unsigned char HAN1,
+                                    unsigned char HAN2,
+                                    unsigned char HAN3);
+static const unsigned char *get_hangul_image (enum eFONTS_HANGUL font,
+                                            unsigned short utf16);
+static const unsigned char *get_glyph_image (__u32 code, int row_bytes);
+static void draw_bitmap (fb_info_t *fb,
+                    int x, int y, const unsigned char *p_img, int row_bytes,
+                    __u32 fg, __u32 bg, int scale);
+static void _fb_blit    (fb_info_t *fb, int x, int y, int w, int h,
+                            const unsigned char *src);
+static glyph_t *_glyph_cache_get (fb_info_t *fb, __u32 code, int row_bytes,
+                    __u32 fg, __u32 bg, int scale);
+static void draw_glyph  (fb_info_t *fb, int x, int y, __u32 code, int row_bytes,
+                    __u32 fg, __u32 bg, int scale);
 static void _draw_text (fb_info_t *fb, int x, int y, char *p_str,
                         int f_color, int b_color, int scale);
+static bool _fb_clip    (fb_info_t *fb, int *x, int *y, int *w, int *h);
+static void _fill_copy_rows (fb_info_t *fb, unsigned char *row, int r_size, int h);
+static void _fb_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color);
+static void _fill_565   (fb_info_t *fb, int x, int y, int w, int h, __u32 px);
+static void _fill_888   (fb_info_t *fb, int x, int y, int w, int h, __u32 px);
+static void _fill_8888  (fb_info_t *fb, int x, int y, int w, int h, __u32 px);
+static void _expand_565 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg);
+static void _expand_888 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg);
+static void _expand_8888(unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg);
+#if defined(__SSE2__)
+static void _expand_8888_sse2 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg);
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+static void _expand_8888_avx2 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg);
+#endif
+#if defined(__ARM_NEON)
+static void _expand_8888_neon (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg);
+#endif
+static void _fb_ops_select (void);
+__u32        fb_pixel  (fb_info_t *fb, int color);
 void         put_pixel (fb_info_t *fb, int x, int y, int color);
 void         draw_text (fb_info_t *fb, int x, int y,
                      int f_color, int b_color, int scale, char *fmt, ...);
@@ -63,28 +132,61 @@ void         draw_line (fb_info_t *fb, int x, int y, int w, int color);
 void         draw_rect (fb_info_t *fb, int x, int y, int w, int h, int lw, int color);
 void         draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color);
 void         set_font(enum eFONTS_HANGUL s_font);
+void         fb_dirty (fb_info_t *fb, int x, int y, int w, int h);
+static void  _fb_copy_rect (fb_info_t *fb, char *dst, fb_rect_t *r);
+static void  _fb_page_flip (fb_info_t *fb);
+static void  _fb_page_init (fb_info_t *fb, struct fb_var_screeninfo *fvsi,
+                            struct fb_fix_screeninfo *ffsi);
+void         fb_flush (fb_info_t *fb);
+static void  _fb_pixel_rgb (fb_info_t *fb, const unsigned char *p, unsigned char *rgb);
+bool         fb_dump (fb_info_t *fb, const char *path);
 void         fb_clear (fb_info_t *fb);
 void         fb_close (fb_info_t *fb);
+static fb_info_t *_fb_init_mem (const char *DEVICE_NAME);
 fb_info_t    *fb_init (const char *DEVICE_NAME);
 
 //-----------------------------------------------------------------------------
 // hangul image base 16x16
 //-----------------------------------------------------------------------------
-static unsigned char HANFontImage[32] = {0,};
+/* 완성형 한글 음절 (U+AC00 ~ U+D7A3) */
+#define HANGUL_BASE         0xAC00
+#define HANGUL_COUNT        11172
+#define HANGUL_IMAGE_SIZE   32
 
 const char D_ML[22] = { 0, 0, 2, 0, 2, 1, 2, 1, 2, 3, 0, 2, 1, 3, 3, 1, 2, 1, 3, 3, 1, 1 																	};
 const char D_FM[40] = { 1, 3, 0, 2, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 1, 3, 0, 2, 1, 3, 1, 3, 1, 3 			};
 const char D_MF[44] = { 0, 0, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 0, 5, 1, 6, 3, 7, 3, 7, 3, 7, 1, 6, 2, 6, 4, 7, 4, 7, 4, 7, 2, 6, 1, 6, 3, 7, 0, 5 };
 
-static unsigned char *HANFONT1 = (unsigned char *)FONT_HANGUL1;
-static unsigned char *HANFONT2 = (unsigned char *)FONT_HANGUL2;
-static unsigned char *HANFONT3 = (unsigned char *)FONT_HANGUL3;
+/* font별 초성 / 중성 / 종성 image */
+#define HAN_FONT_SET(n)     { (const unsigned char *)n##1, \
+                              (const unsigned char *)n##2, \
+                              (const unsigned char *)n##3 }
+
+static const unsigned char *HanFontSet[eFONT_END][3] = {
+    [eFONT_HAN_DEFAULT] = HAN_FONT_SET(FONT_HANGUL),
+    [eFONT_HANBOOT]     = HAN_FONT_SET(FONT_HANBOOT),
+    [eFONT_HANGODIC]    = HAN_FONT_SET(FONT_HANGODIC),
+    [eFONT_HANPIL]      = HAN_FONT_SET(FONT_HANPIL),
+    [eFONT_HANSOFT]     = HAN_FONT_SET(FONT_HANSOFT),
+};
+
+/*
+    font별 조합이 완료된 11,172자 음절 image (처음 사용될 때 생성, 읽기 전용)
+    생성된 table은 atomic으로 등록되므로 여러 thread에서 동시에 사용할 수 있다.
+*/
+static unsigned char *HanTable[eFONT_END];
+
+/* 완성형 한글 이외의 문자 */
+static const unsigned char HanBlankImage[HANGUL_IMAGE_SIZE];
+
+/* 현재 선택된 hangul font */
+static enum eFONTS_HANGUL HanFontType = eFONT_HAN_DEFAULT;
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 static void make_image  (unsigned char is_first,
                         unsigned char *dest,
-                        unsigned char *src)
+                        const unsigned char *src)
 {
     int i;
     if (is_first)   for (i = 0; i < 32; i++)    dest[i]  = src[i];
@@ -92,126 +194,522 @@ static void make_image  (unsigned char is_first,
 }
 
 //-----------------------------------------------------------------------------
-static unsigned char *get_hangul_image( unsigned char HAN1,
-                                        unsigned char HAN2,
-                                        unsigned char HAN3)
+// 음절 index(0 ~ 11171)의 초성 / 중성 / 종성을 조합
+//-----------------------------------------------------------------------------
+static void make_hangul_image (enum eFONTS_HANGUL font, unsigned short idx,
+                        unsigned char *dest)
 {
+    const unsigned char *HANFONT1 = HanFontSet[font][0];
+    const unsigned char *HANFONT2 = HanFontSet[font][1];
+    const unsigned char *HANFONT3 = HanFontSet[font][2];
     unsigned char f, m, l;
     unsigned char f1, f2, f3;
     unsigned char first_flag = 1;
-    unsigned short utf16 = 0;
 
+    /* 초성 / 중성 / 종성 분리 */
+    l = (idx % 28);
+    idx /= 28;
+    m = (idx % 21) +1;
+    f = (idx / 21) +1;
+
+    /* 초성 / 중성 / 종성 형태에 따른 이미지 선택 */
+    f3 = D_ML[m];
+    f2 = D_FM[(f * 2) + (l != 0)];
+    f1 = D_MF[(m * 2) + (l != 0)];
+
+    memset(dest, 0, HANGUL_IMAGE_SIZE);
+    if (f)  {   make_image(         1, dest, HANFONT1 + (f1*16 + f1 *4 + f) * 32);    first_flag = 0; }
+    if (m)  {   make_image(first_flag, dest, HANFONT2 + (        f2*22 + m) * 32);    first_flag = 0; }
+    if (l)  {   make_image(first_flag, dest, HANFONT3 + (f3*32 - f3 *4 + l) * 32);    first_flag = 0; }
+}
+
+//-----------------------------------------------------------------------------
+static unsigned short utf8_to_utf16 (unsigned char HAN1,
+                                    unsigned char HAN2,
+                                    unsigned char HAN3)
+{
     /*------------------------------
     UTF-8 을 UTF-16으로 변환한다.
 
     UTF-8 1110xxxx 10xxxxxx 10xxxxxx
     ------------------------------*/
-    utf16 = ((unsigned short)HAN1 & 0x000f) << 12 |
+    return  ((unsigned short)HAN1 & 0x000f) << 12 |
             ((unsigned short)HAN2 & 0x003f) << 6  |
             ((unsigned short)HAN3 & 0x003f);
-    utf16 -= 0xAC00;
+}
 
-    /* 초성 / 중성 / 종성 분리 */
-    l = (utf16 % 28);
-    utf16 /= 28;
-    m = (utf16 % 21) +1;
-    f = (utf16 / 21) +1;
+//-----------------------------------------------------------------------------
+// 완성형 table에서 음절 image를 얻는다. (table이 없으면 font 전체를 조합하여 생성)
+//-----------------------------------------------------------------------------
+static const unsigned char *get_hangul_image (enum eFONTS_HANGUL font,
+                                            unsigned short utf16)
+{
+    unsigned char *table, *expect = NULL;
+    int i;
 
-    /* 초성 / 중성 / 종성 형태에 따른 이미지 선택 */
-    f3 = D_ML[m];
-    f2 = D_FM[(f * 2) + (l != 0)];
-    f1 = D_MF[(m * 2) + (l != 0)];
+    if ((utf16 < HANGUL_BASE) || (utf16 >= HANGUL_BASE + HANGUL_COUNT))
+        return HanBlankImage;
 
-    memset(HANFontImage, 0, sizeof(HANFontImage));
-    if (f)  {   make_image(         1, HANFontImage, HANFONT1 + (f1*16 + f1 *4 + f) * 32);    first_flag = 0; }
-    if (m)  {   make_image(first_flag, HANFontImage, HANFONT2 + (        f2*22 + m) * 32);    first_flag = 0; }
-    if (l)  {   make_image(first_flag, HANFontImage, HANFONT3 + (f3*32 - f3 *4 + l) * 32);    first_flag = 0; }
+    if ((table = __atomic_load_n (&HanTable[font], __ATOMIC_ACQUIRE)) == NULL) {
+        if ((table = (unsigned char *)malloc (HANGUL_COUNT * HANGUL_IMAGE_SIZE)) == NULL)
+            return HanBlankImage;
 
-    return HANFontImage;
+        for (i = 0; i < HANGUL_COUNT; i++)
+            make_hangul_image (font, i, table + i * HANGUL_IMAGE_SIZE);
+
+        /* 다른 thread가 먼저 생성한 경우 그 table을 사용 */
+        if (!__atomic_compare_exchange_n (&HanTable[font], &expect, table, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free (table);
+            table = expect;
+        }
+    }
+    return table + (utf16 - HANGUL_BASE) * HANGUL_IMAGE_SIZE;
 }
 
 //-----------------------------------------------------------------------------
-void put_pixel (fb_info_t *fb, int x, int y, int color)
+// glyph bitmap (row_bytes : ascii = 1, hangul = 2)
+//-----------------------------------------------------------------------------
+static const unsigned char *get_glyph_image (__u32 code, int row_bytes)
+{
+    if (row_bytes == 1)
+        return (const unsigned char *)FONT_ASCII[code & 0x7F];
+    return get_hangul_image (HanFontType, code);
+}
+
+//-----------------------------------------------------------------------------
+// pixel format별 fill / glyph 확장 함수 (fb_init에서 한번 선택)
+// XRGB8888 glyph 확장은 _fb_ops_select에서 CPU에 맞는 SIMD kernel로 바뀐다.
+//-----------------------------------------------------------------------------
+static fb_ops_t FbOps[eFB_FORMAT_END] = {
+    [eFB_FORMAT_RGB565]   = { _fill_565,  _expand_565  },
+    [eFB_FORMAT_RGB888]   = { _fill_888,  _expand_888  },
+    [eFB_FORMAT_XRGB8888] = { _fill_8888, _expand_8888 },
+};
+
+/* glyph 1 row 확장용 buffer 크기 (hangul 16 pixel x scale x 4 bytes) */
+#define GLYPH_SCALE_MAX     128
+#define GLYPH_LINE_SIZE     (FONT_HANGUL_WIDTH * GLYPH_SCALE_MAX * 4)
+
+//-----------------------------------------------------------------------------
+// RGB color(RGB_TO_UINT)를 framebuffer의 native pixel 값으로 변환
+//-----------------------------------------------------------------------------
+__u32 fb_pixel (fb_info_t *fb, int color)
 {
-    fb_color_u c;
-    int offset = (y * fb->stride) + (x * (fb->bpp >> 3));
-
-    if ((x < fb->w) && (y < fb->h)) {
-        c.uint = color;
-        if (fb->is_bgr) {
-            *(fb->data + offset) = c.bits.b;  offset++;
-            *(fb->data + offset) = c.bits.g;  offset++;
-            *(fb->data + offset) = c.bits.r;  offset++;
-        } else {
-            *(fb->data + offset) = c.bits.r;  offset++;
-            *(fb->data + offset) = c.bits.g;  offset++;
-            *(fb->data + offset) = c.bits.b;  offset++;
+    __u32 r = UINT_TO_R(color), g = UINT_TO_G(color), b = UINT_TO_B(color), t;
+
+    /* is_bgr = red가 상위 bit */
+    if (!fb->is_bgr) {
+        t = r;  r = b;  b = t;
+    }
+    switch (fb->format) {
+        case    eFB_FORMAT_RGB565:
+            return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        case    eFB_FORMAT_RGB888:
+            return (r << 16) | (g << 8) | b;
+        case    eFB_FORMAT_XRGB8888:
+        default :
+            return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// 화면 영역으로 clipping (return : 그릴 영역이 없으면 false)
+//-----------------------------------------------------------------------------
+static bool _fb_clip (fb_info_t *fb, int *x, int *y, int *w, int *h)
+{
+    if (*x < 0) {   *w += *x;   *x = 0; }
+    if (*y < 0) {   *h += *y;   *y = 0; }
+    if (*x + *w > fb->w)    *w = fb->w - *x;
+    if (*y + *h > fb->h)    *h = fb->h - *y;
+
+    return ((*w > 0) && (*h > 0)) ? true : false;
+}
+
+//-----------------------------------------------------------------------------
+// 모든 도형의 기본 함수. clipping과 color 변환은 한번만 하고 row 단위로 채운다.
+//-----------------------------------------------------------------------------
+static void _fb_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color)
+{
+    if (_fb_clip (fb, &x, &y, &w, &h)) {
+        fb->ops->fill (fb, x, y, w, h, fb_pixel (fb, color));
+        fb_dirty (fb, x, y, w, h);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// 첫 row를 채운 후 나머지 row는 첫 row를 복사한다.
+//-----------------------------------------------------------------------------
+static void _fill_copy_rows (fb_info_t *fb, unsigned char *row, int r_size, int h)
+{
+    int n;
+
+    for (n = 1; n < h; n++)
+        memcpy (row + n * fb->stride, row, r_size);
+}
+
+//-----------------------------------------------------------------------------
+static void _fill_565 (fb_info_t *fb, int x, int y, int w, int h, __u32 px)
+{
+    __u16 *row = (__u16 *)(fb->data + (y * fb->stride) + (x * 2));
+    int i;
+
+    for (i = 0; i < w; i++)
+        row[i] = px;
+    _fill_copy_rows (fb, (unsigned char *)row, w * 2, h);
+}
+
+//-----------------------------------------------------------------------------
+// 24bpp는 pixel이 정렬되지 않으므로 첫 pixel부터 2배씩 복사하여 row를 만든다.
+//-----------------------------------------------------------------------------
+static void _fill_888 (fb_info_t *fb, int x, int y, int w, int h, __u32 px)
+{
+    unsigned char *row = (unsigned char *)fb->data + (y * fb->stride) + (x * 3);
+    int r_size = w * 3, done, n;
+
+    row[0] = px;    row[1] = px >> 8;   row[2] = px >> 16;
+    for (done = 3; done < r_size; done += n) {
+        n = (done < r_size - done) ? done : r_size - done;
+        memcpy (row + done, row, n);
+    }
+    _fill_copy_rows (fb, row, r_size, h);
+}
+
+//-----------------------------------------------------------------------------
+static void _fill_8888 (fb_info_t *fb, int x, int y, int w, int h, __u32 px)
+{
+    __u32 *row = (__u32 *)(fb->data + (y * fb->stride) + (x * 4));
+    __u64 px2 = ((__u64)px << 32) | px;
+    int i = 0;
+
+    /* 8 bytes 정렬 후 2 pixel씩 저장 */
+    if (((unsigned long)row & 7) && w) {
+        row[0] = px;
+        i = 1;
+    }
+    for (; i + 1 < w; i += 2)
+        *(__u64 *)&row[i] = px2;
+    if (i < w)
+        row[i] = px;
+    _fill_copy_rows (fb, (unsigned char *)row, w * 4, h);
+}
+
+//-----------------------------------------------------------------------------
+static void _expand_565 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg)
+{
+    __u16 *d = (__u16 *)dst, c;
+    int i, s;
+
+    for (i = 0; i < n; i++) {
+        c = (bits[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+        for (s = 0; s < scale; s++)
+            *d++ = c;
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void _expand_888 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg)
+{
+    __u32 c;
+    int i, s;
+
+    for (i = 0; i < n; i++) {
+        c = (bits[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+        for (s = 0; s < scale; s++) {
+            *dst++ = c; *dst++ = c >> 8;    *dst++ = c >> 16;
         }
-        if (fb->bpp == 32)
-            *(fb->data + offset) = 0xFF;
-    } else {
-        dbg("Out of range.(width = %d, x = %d, height = %d, y = %d)\n", 
-            fb->w, x, fb->h, y);
     }
 }
 
 //-----------------------------------------------------------------------------
-static void draw_hangul_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
-                    int f_color, int b_color, int scale)
+static void _expand_8888 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg)
 {
-    int pos, i, j, mask, x_off, y_off, scale_y, scale_x;
+    __u32 *d = (__u32 *)dst, c;
+    int i, s;
 
-    for (i = 0, y_off = 0, pos = 0; i < 16; i++) {
-        for (scale_y = 0; scale_y < scale; scale_y++) {
-            if (scale_y)
-                pos -= 2;
-            for (x_off = 0, j = 0; j < 2; j++) {
-                for (mask = 0x80; mask > 0; mask >>= 1) {
-                    for (scale_x = 0; scale_x < scale; scale_x++) {
-                        int c;
-                        c = (p_img[pos] & mask) ? f_color : b_color;
+    for (i = 0; i < n; i++) {
+        c = (bits[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+        for (s = 0; s < scale; s++)
+            *d++ = c;
+    }
+}
 
-                        put_pixel(fb, x + x_off, y + y_off, c);
-                        x_off++;
-                    }
-                }
-                pos++;
-            }
-            y_off++;
+//-----------------------------------------------------------------------------
+// SIMD glyph 확장 kernel (XRGB8888)
+//   scale = 1 : bitmap bit를 mask로 만들어 fg/bg를 한번에 선택
+//   scale > 1 : bit 마다 fg 또는 bg를 vector store로 scale개 반복
+//-----------------------------------------------------------------------------
+#if defined(__SSE2__)
+static void _expand_8888_sse2 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg)
+{
+    const __m128i sel = _mm_set_epi32 (1, 2, 4, 8);
+    __m128i vf = _mm_set1_epi32 (fg), vb = _mm_set1_epi32 (bg), m, c;
+    __u32 *d = (__u32 *)dst;
+    int i = 0, s;
+
+    if (scale == 1) {
+        /* 4 bit(nibble) -> 4 pixel */
+        for (; i + 4 <= n; i += 4, d += 4) {
+            __u32 nib = (bits[i >> 3] >> (4 - (i & 7))) & 0xF;
+
+            m = _mm_and_si128 (_mm_set1_epi32 (nib), sel);
+            m = _mm_cmpeq_epi32 (m, sel);
+            _mm_storeu_si128 ((__m128i *)d,
+                _mm_or_si128 (_mm_and_si128 (m, vf), _mm_andnot_si128 (m, vb)));
         }
     }
+    for (; i < n; i++) {
+        /* branch 없이 선택 (glyph bit는 예측이 어렵다) */
+        __u32 on = -((bits[i >> 3] >> (7 - (i & 7))) & 1), p = bg ^ ((fg ^ bg) & on);
+
+        c = _mm_set1_epi32 (p);
+        for (s = 0; s + 4 <= scale; s += 4, d += 4)
+            _mm_storeu_si128 ((__m128i *)d, c);
+        for (; s < scale; s++)
+            *d++ = p;
+    }
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void _expand_8888_avx2 (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg)
+{
+    const __m256i sel = _mm256_set_epi32 (1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i vf = _mm256_set1_epi32 (fg), vb = _mm256_set1_epi32 (bg), m, c;
+    __u32 *d = (__u32 *)dst;
+    int i = 0, s;
+
+    if (scale == 1) {
+        /* 1 byte -> 8 pixel */
+        for (; i + 8 <= n; i += 8, d += 8) {
+            m = _mm256_and_si256 (_mm256_set1_epi32 (bits[i >> 3]), sel);
+            m = _mm256_cmpeq_epi32 (m, sel);
+            _mm256_storeu_si256 ((__m256i *)d, _mm256_blendv_epi8 (vb, vf, m));
+        }
+    }
+    for (; i < n; i++) {
+        __u32 on = -((bits[i >> 3] >> (7 - (i & 7))) & 1), p = bg ^ ((fg ^ bg) & on);
+
+        c = _mm256_set1_epi32 (p);
+        for (s = 0; s + 8 <= scale; s += 8, d += 8)
+            _mm256_storeu_si256 ((__m256i *)d, c);
+        if (s + 4 <= scale) {
+            _mm_storeu_si128 ((__m128i *)d, _mm256_castsi256_si128 (c));
+            s += 4;     d += 4;
+        }
+        for (; s < scale; s++)
+            *d++ = p;
+    }
 }
+#endif
+
+#if defined(__ARM_NEON)
+static void _expand_8888_neon (unsigned char *dst, const unsigned char *bits, int n,
+                            int scale, __u32 fg, __u32 bg)
+{
+    static const uint32_t sel_tbl[4] = { 8, 4, 2, 1 };
+    uint32x4_t sel = vld1q_u32 (sel_tbl), vf = vdupq_n_u32 (fg), vb = vdupq_n_u32 (bg), c;
+    __u32 *d = (__u32 *)dst;
+    int i = 0, s;
+
+    if (scale == 1) {
+        /* 4 bit(nibble) -> 4 pixel */
+        for (; i + 4 <= n; i += 4, d += 4) {
+            __u32 nib = (bits[i >> 3] >> (4 - (i & 7))) & 0xF;
 
+            vst1q_u32 (d, vbslq_u32 (vtstq_u32 (vdupq_n_u32 (nib), sel), vf, vb));
+        }
+    }
+    for (; i < n; i++) {
+        __u32 on = -((bits[i >> 3] >> (7 - (i & 7))) & 1), p = bg ^ ((fg ^ bg) & on);
+
+        c = vdupq_n_u32 (p);
+        for (s = 0; s + 4 <= scale; s += 4, d += 4)
+            vst1q_u32 (d, c);
+        for (; s < scale; s++)
+            *d++ = p;
+    }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// CPU가 지원하는 glyph 확장 kernel 선택 (없으면 scalar)
 //-----------------------------------------------------------------------------
-static void draw_ascii_bitmap (fb_info_t *fb,
-                    int x, int y, unsigned char *p_img,
-                    int f_color, int b_color, int scale)
+static void _fb_ops_select (void)
 {
-    int pos, mask, x_off, y_off, scale_y, scale_x;
+    static bool selected = false;
+    const char *name = "scalar";
 
-    for (pos = 0, y_off = 0; pos < 16; pos++) {
-        for (scale_y = 0; scale_y < scale; scale_y++) {
-            for (x_off = 0, mask = 0x80; mask > 0; mask >>= 1) {
-                for (scale_x = 0; scale_x < scale; scale_x++) {
-                    int c;
-                    c = (p_img[pos] & mask) ? f_color : b_color;
+    if (selected)
+        return;
+    selected = true;
 
-                    put_pixel(fb, x + x_off, y + y_off, c);
-                    x_off++;
-                }
-            }
-            y_off++;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2")) {
+        FbOps[eFB_FORMAT_XRGB8888].expand = _expand_8888_avx2;
+        name = "avx2";
+    }
+#if defined(__SSE2__)
+    else {
+        FbOps[eFB_FORMAT_XRGB8888].expand = _expand_8888_sse2;
+        name = "sse2";
+    }
+#endif
+#elif defined(__ARM_NEON)
+    FbOps[eFB_FORMAT_XRGB8888].expand = _expand_8888_neon;
+    name = "neon";
+#endif
+    info("glyph expand kernel : %s\n", name);
+}
+
+//-----------------------------------------------------------------------------
+void put_pixel (fb_info_t *fb, int x, int y, int color)
+{
+    /* 화면 밖의 pixel은 무시 */
+    if ((x < 0) || (y < 0) || (x >= fb->w) || (y >= fb->h))
+        return;
+
+    fb->ops->fill (fb, x, y, 1, 1, fb_pixel (fb, color));
+    fb_dirty (fb, x, y, 1, 1);
+}
+
+//-----------------------------------------------------------------------------
+// 16 row bitmap font를 그린다. (row_bytes : ascii = 1, hangul = 2)
+// bitmap 1 row를 확장한 후 scale 만큼 clipping된 영역을 복사한다.
+//-----------------------------------------------------------------------------
+static void draw_bitmap (fb_info_t *fb,
+                    int x, int y, const unsigned char *p_img, int row_bytes,
+                    __u32 fg, __u32 bg, int scale)
+{
+    unsigned char line[GLYPH_LINE_SIZE] __attribute__((aligned(8)));
+    int w, h, cx, cy, cw, ch, i, dy;
+
+    scale = (scale > GLYPH_SCALE_MAX) ? GLYPH_SCALE_MAX : scale;
+    w = row_bytes * 8 * scale;
+    h = FONT_HEIGHT * scale;
+
+    cx = x; cy = y; cw = w; ch = h;
+    if (!_fb_clip (fb, &cx, &cy, &cw, &ch))
+        return;
+    fb_dirty (fb, cx, cy, cw, ch);
+
+    for (i = (cy - y) / scale; i < FONT_HEIGHT; i++) {
+        fb->ops->expand (line, &p_img[i * row_bytes], row_bytes * 8, scale, fg, bg);
+
+        for (dy = i * scale; dy < (i + 1) * scale; dy++) {
+            if ((y + dy) < cy)
+                continue;
+            if ((y + dy) >= (cy + ch))
+                return;
+            memcpy (fb->data + (y + dy) * fb->stride + cx * fb->p_size,
+                    &line[(cx - x) * fb->p_size], cw * fb->p_size);
         }
     }
 }
 
+//-----------------------------------------------------------------------------
+// 화면 영역만큼 pixel block 복사 (src는 w pixel 단위 row가 연속)
+//-----------------------------------------------------------------------------
+static void _fb_blit (fb_info_t *fb, int x, int y, int w, int h,
+                        const unsigned char *src)
+{
+    int cx = x, cy = y, cw = w, ch = h, s_pitch = w * fb->p_size, i;
+    unsigned char *dst;
+
+    if (!_fb_clip (fb, &cx, &cy, &cw, &ch))
+        return;
+    fb_dirty (fb, cx, cy, cw, ch);
+
+    src += (cy - y) * s_pitch + (cx - x) * fb->p_size;
+    dst  = (unsigned char *)fb->data + cy * fb->stride + cx * fb->p_size;
+    for (i = 0; i < ch; i++, src += s_pitch, dst += fb->stride)
+        memcpy (dst, src, cw * fb->p_size);
+}
+
+//-----------------------------------------------------------------------------
+// cache에서 glyph를 찾고 없으면 확장하여 저장 (return NULL : cache 하지 않음)
+//-----------------------------------------------------------------------------
+static glyph_t *_glyph_cache_get (fb_info_t *fb, __u32 code, int row_bytes,
+                    __u32 fg, __u32 bg, int scale)
+{
+    const unsigned char *p_img;
+    int font = (row_bytes == 1) ? GLYPH_FONT_ASCII : (int)HanFontType;
+    int w = row_bytes * 8 * scale, h = FONT_HEIGHT * scale, size, i, s;
+    glyph_cache_t *gc = fb->gcache;
+    glyph_t *g;
+    __u32 hash;
+
+    size = w * h * fb->p_size;
+    if (size > GLYPH_CACHE_BLOCK_MAX)
+        return NULL;
+
+    if (gc == NULL) {
+        if ((gc = (glyph_cache_t *)calloc (1, sizeof(glyph_cache_t))) == NULL)
+            return NULL;
+        fb->gcache = gc;
+    }
+
+    hash = (code * 2654435761u) ^ (font * 97) ^ (scale * 131) ^ (fg * 31) ^ bg;
+    g = &gc->slot[(hash ^ (hash >> 16)) & (GLYPH_CACHE_COUNT - 1)];
+
+    if (g->data && (g->code == code) && (g->font == font) &&
+        (g->scale == scale) && (g->fg == fg) && (g->bg == bg)) {
+        gc->hit++;
+        return g;
+    }
+    gc->miss++;
+
+    /* 같은 slot을 사용하던 glyph는 버린다. */
+    if (g->size < size) {
+        free (g->data);
+        if ((g->data = (unsigned char *)malloc (size)) == NULL) {
+            g->size = 0;
+            return NULL;
+        }
+        g->size = size;
+    }
+    g->code  = code;    g->font = font; g->scale = scale;
+    g->fg    = fg;      g->bg   = bg;
+    g->w     = w;       g->h    = h;
+
+    /* bitmap 1 row를 확장하고 scale 만큼 복사 */
+    p_img = get_glyph_image (code, row_bytes);
+    for (i = 0; i < FONT_HEIGHT; i++) {
+        unsigned char *row = g->data + (i * scale) * w * fb->p_size;
+
+        fb->ops->expand (row, &p_img[i * row_bytes], row_bytes * 8, scale, fg, bg);
+        for (s = 1; s < scale; s++)
+            memcpy (row + s * w * fb->p_size, row, w * fb->p_size);
+    }
+    return g;
+}
+
+//-----------------------------------------------------------------------------
+static void draw_glyph (fb_info_t *fb, int x, int y, __u32 code, int row_bytes,
+                    __u32 fg, __u32 bg, int scale)
+{
+    glyph_t *g = _glyph_cache_get (fb, code, row_bytes, fg, bg, scale);
+
+    if (g != NULL)
+        _fb_blit (fb, x, y, g->w, g->h, g->data);
+    else
+        draw_bitmap (fb, x, y, get_glyph_image (code, row_bytes),
+                        row_bytes, fg, bg, scale);
+}
+
 //-----------------------------------------------------------------------------
 static void _draw_text (fb_info_t *fb, int x, int y, char *p_str,
                         int f_color, int b_color, int scale)
 {
-    unsigned char *p_img;
     unsigned char c1, c2, c3;
+    __u32 fg = fb_pixel (fb, f_color), bg = fb_pixel (fb, b_color);
 
     while(*p_str) { 
         c1 = *(unsigned char *)p_str++;
@@ -223,14 +721,12 @@ static void _draw_text (fb_info_t *fb, int x, int y, char *p_str,
             c2 = *(unsigned char *)p_str++;
             c3 = *(unsigned char *)p_str++;
 
-            p_img = get_hangul_image(c1, c2, c3);
-            draw_hangul_bitmap(fb, x, y, p_img, f_color, b_color, scale);
+            draw_glyph(fb, x, y, utf8_to_utf16(c1, c2, c3), 2, fg, bg, scale);
             x = x + FONT_HANGUL_WIDTH * scale;
         }
         //---------- ASCII ---------
         else {
-            p_img = (unsigned char *)FONT_ASCII[c1];
-            draw_ascii_bitmap(fb, x, y, p_img, f_color, b_color, scale);
+            draw_glyph(fb, x, y, c1, 1, fg, bg, scale);
             x = x + FONT_ASCII_WIDTH * scale;
         }
     }  
@@ -255,95 +751,403 @@ void draw_text (fb_info_t *fb, int x, int y,
 //-----------------------------------------------------------------------------
 void draw_line (fb_info_t *fb, int x, int y, int w, int color)
 {
-    int dx;
-
-    for (dx = 0; dx < w; dx++)
-        put_pixel(fb, x + dx, y, color);
+    _fb_fill_rect (fb, x, y, w, 1, color);
 }
 
 //-----------------------------------------------------------------------------
 void draw_rect (fb_info_t *fb, int x, int y, int w, int h, int lw, int color)
 {
-	int dy, i;
+    lw = (lw > h) ? h : lw;
 
-	for (dy = 0; dy < h; dy++) {
-        if (dy < lw || (dy > (h - lw -1)))
-            draw_line (fb, x, y + dy, w, color);
-        else {
-            for (i = 0; i < lw; i++) {
-                put_pixel (fb, x + 0    +i, y + dy, color);
-                put_pixel (fb, x + w -1 -i, y + dy, color);
+    /* top, bottom line */
+    _fb_fill_rect (fb, x, y,          w, lw, color);
+    _fb_fill_rect (fb, x, y + h - lw, w, lw, color);
+
+    /* left, right line */
+    if (h > (lw * 2)) {
+        _fb_fill_rect (fb, x,          y + lw, lw, h - lw * 2, color);
+        _fb_fill_rect (fb, x + w - lw, y + lw, lw, h - lw * 2, color);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color)
+{
+    _fb_fill_rect (fb, x, y, w, h, color);
+}
+
+//-----------------------------------------------------------------------------
+void set_font(enum eFONTS_HANGUL s_font)
+{
+    HanFontType = ((s_font >= eFONT_HAN_DEFAULT) && (s_font < eFONT_END)) ?
+                        s_font : eFONT_HAN_DEFAULT;
+}
+
+//-----------------------------------------------------------------------------
+// 변경 영역 등록. 겹치거나 붙어있는 영역은 합치고 목록이 가득 차면
+// 가장 적게 커지는 영역에 합친다. (x, y, w, h는 clipping된 값)
+//-----------------------------------------------------------------------------
+void fb_dirty (fb_info_t *fb, int x, int y, int w, int h)
+{
+    int x1 = x + w, y1 = y + h, i, best = 0;
+    long grow, best_grow = LONG_MAX;
+    fb_rect_t *r, m;
+
+    /* shadow buffer를 사용하지 않으면 이미 화면에 그려져 있음 */
+    if (fb->data == fb->dev)
+        return;
+
+    for (i = 0; i < fb->dirty_cnt; ) {
+        r = &fb->dirty[i];
+        if ((x <= r->x + r->w) && (r->x <= x1) && (y <= r->y + r->h) && (r->y <= y1)) {
+            /* 합친 영역이 다른 영역과 겹칠 수 있으므로 처음부터 다시 검사 */
+            x  = (r->x < x) ? r->x : x;
+            y  = (r->y < y) ? r->y : y;
+            x1 = (r->x + r->w > x1) ? r->x + r->w : x1;
+            y1 = (r->y + r->h > y1) ? r->y + r->h : y1;
+            *r = fb->dirty[--fb->dirty_cnt];
+            i  = 0;
+            continue;
+        }
+        i++;
+    }
+
+    if (fb->dirty_cnt == FB_DIRTY_MAX) {
+        for (i = 0; i < fb->dirty_cnt; i++) {
+            r = &fb->dirty[i];
+            grow = (long)(((r->x + r->w > x1) ? r->x + r->w : x1) - ((r->x < x) ? r->x : x)) *
+                         (((r->y + r->h > y1) ? r->y + r->h : y1) - ((r->y < y) ? r->y : y)) -
+                   (long)r->w * r->h;
+            if (grow < best_grow) {
+                best_grow = grow;
+                best = i;
             }
         }
-	}
+        m = fb->dirty[best];
+        fb->dirty[best] = fb->dirty[--fb->dirty_cnt];
+        fb_dirty (fb, (m.x < x) ? m.x : x, (m.y < y) ? m.y : y,
+                    ((m.x + m.w > x1) ? m.x + m.w : x1) - ((m.x < x) ? m.x : x),
+                    ((m.y + m.h > y1) ? m.y + m.h : y1) - ((m.y < y) ? m.y : y));
+        return;
+    }
+    r = &fb->dirty[fb->dirty_cnt++];
+    r->x = x;   r->y = y;   r->w = x1 - x;  r->h = y1 - y;
 }
 
 //-----------------------------------------------------------------------------
-void draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color)
+// shadow buffer의 r 영역을 dst(page 시작 위치)로 row 단위 복사
+//-----------------------------------------------------------------------------
+static void _fb_copy_rect (fb_info_t *fb, char *dst, fb_rect_t *r)
 {
-	int dy;
+    int dy, offset = r->y * fb->stride + r->x * fb->p_size, size = r->w * fb->p_size;
 
-	for (dy = 0; dy < h; dy++)
-        draw_line(fb, x, y + dy, w, color);
+    /* 화면 폭 전체인 경우 한번에 복사 */
+    if (size == fb->stride) {
+        memcpy (dst + offset, fb->data + offset, size * r->h);
+        return;
+    }
+    for (dy = 0; dy < r->h; dy++, offset += fb->stride)
+        memcpy (dst + offset, fb->data + offset, size);
 }
 
 //-----------------------------------------------------------------------------
-void set_font(enum eFONTS_HANGUL s_font)
+// back page에 변경 영역을 복사한 후 FBIOPAN_DISPLAY로 표시 page 변경
+//-----------------------------------------------------------------------------
+static void _fb_page_flip (fb_info_t *fb)
+{
+    struct fb_var_screeninfo fvsi;
+    fb_rect_t cur[FB_DIRTY_MAX];
+    int cur_cnt = fb->dirty_cnt, back = fb->page ^ 1, i;
+    __u32 crtc = 0;
+
+    /*
+        back page는 이전 flush 이전의 화면이므로
+        이전 flush 영역과 현재 영역을 모두 복사해야 한다.
+    */
+    memcpy (cur, fb->dirty, sizeof(fb_rect_t) * cur_cnt);
+    for (i = 0; i < fb->prev_cnt; i++)
+        fb_dirty (fb, fb->prev_dirty[i].x, fb->prev_dirty[i].y,
+                    fb->prev_dirty[i].w, fb->prev_dirty[i].h);
+
+    for (i = 0; i < fb->dirty_cnt; i++)
+        _fb_copy_rect (fb, fb->dev + back * fb->h * fb->stride, &fb->dirty[i]);
+
+    /*
+        flip하지 못한 경우 표시중인 page는 이전 영역과 현재 영역이 모두 빠져있으므로
+        다음 flip 후 back page에 복사할 영역은 합쳐진 영역 전체가 된다.
+    */
+    if (ioctl (fb->fd, FBIOGET_VSCREENINFO, &fvsi) < 0) {
+        memcpy (fb->prev_dirty, fb->dirty, sizeof(fb_rect_t) * fb->dirty_cnt);
+        fb->prev_cnt = fb->dirty_cnt;
+        return;
+    }
+
+    /* vsync를 지원하지 않는 driver는 한번 실패 후 사용하지 않는다. */
+    if (fb->vsync && (ioctl (fb->fd, FBIO_WAITFORVSYNC, &crtc) < 0))
+        fb->vsync = false;
+
+    fvsi.xoffset = 0;
+    fvsi.yoffset = back * fb->h;
+    if (ioctl (fb->fd, FBIOPAN_DISPLAY, &fvsi) < 0) {
+        /* pan 실패 : 표시중인 page에 직접 복사 */
+        err("ioctl(FBIOPAN_DISPLAY) fail, page flip disabled.\n");
+        fb->page_cnt = 1;
+        for (i = 0; i < fb->dirty_cnt; i++)
+            _fb_copy_rect (fb, fb->dev + fb->page * fb->h * fb->stride, &fb->dirty[i]);
+        /* 표시중인 page를 dev로 사용 (이후 page offset은 0) */
+        fb->dev += fb->page * fb->h * fb->stride;
+        fb->page     = 0;
+        fb->prev_cnt = 0;
+        return;
+    }
+    /* 이전 page(새 back page)는 현재 영역만 빠져있다. */
+    memcpy (fb->prev_dirty, cur, sizeof(fb_rect_t) * cur_cnt);
+    fb->prev_cnt = cur_cnt;
+    fb->page = back;
+}
+
+//-----------------------------------------------------------------------------
+// 변경된 영역을 화면에 반영 (page flip 또는 device memory로 복사)
+//-----------------------------------------------------------------------------
+void fb_flush (fb_info_t *fb)
+{
+    int i;
+
+    if (!fb->dirty_cnt)
+        return;
+
+    if (fb->page_cnt > 1)
+        _fb_page_flip (fb);
+    else
+        for (i = 0; i < fb->dirty_cnt; i++)
+            _fb_copy_rect (fb, fb->dev, &fb->dirty[i]);
+
+    fb->dirty_cnt = 0;
+
+    if (fb->backend == eFB_BACKEND_FILE)
+        fb_dump (fb, fb->dump_path);
+}
+
+//-----------------------------------------------------------------------------
+// native pixel -> R, G, B (fb_pixel의 역변환)
+//-----------------------------------------------------------------------------
+static void _fb_pixel_rgb (fb_info_t *fb, const unsigned char *p, unsigned char *rgb)
 {
-    switch(s_font)
-    {
-        case    eFONT_HANBOOT:
-            HANFONT1 = (unsigned char *)FONT_HANBOOT1;
-            HANFONT2 = (unsigned char *)FONT_HANBOOT2;
-            HANFONT3 = (unsigned char *)FONT_HANBOOT3;
-        break;
-        case    eFONT_HANGODIC:
-            HANFONT1 = (unsigned char *)FONT_HANGODIC1;
-            HANFONT2 = (unsigned char *)FONT_HANGODIC2;
-            HANFONT3 = (unsigned char *)FONT_HANGODIC3;
-        break;
-        case    eFONT_HANPIL:
-            HANFONT1 = (unsigned char *)FONT_HANPIL1;
-            HANFONT2 = (unsigned char *)FONT_HANPIL2;
-            HANFONT3 = (unsigned char *)FONT_HANPIL3;
-        break;
-        case    eFONT_HANSOFT:
-            HANFONT1 = (unsigned char *)FONT_HANSOFT1;
-            HANFONT2 = (unsigned char *)FONT_HANSOFT2;
-            HANFONT3 = (unsigned char *)FONT_HANSOFT3;
-        break;
-        case    eFONT_HAN_DEFAULT:
+    __u32 px;
+    unsigned char t;
+
+    switch (fb->format) {
+        case    eFB_FORMAT_RGB565:
+            px = p[0] | (p[1] << 8);
+            rgb[0] = ((px >> 11) & 0x1F) << 3;
+            rgb[1] = ((px >>  5) & 0x3F) << 2;
+            rgb[2] = ((px      ) & 0x1F) << 3;
+            break;
+        case    eFB_FORMAT_RGB888:
+        case    eFB_FORMAT_XRGB8888:
         default :
-            HANFONT1 = (unsigned char *)FONT_HANGUL1;
-            HANFONT2 = (unsigned char *)FONT_HANGUL2;
-            HANFONT3 = (unsigned char *)FONT_HANGUL3;
-        break;
+            rgb[0] = p[2];  rgb[1] = p[1];  rgb[2] = p[0];
+            break;
+    }
+    /* is_bgr = red가 상위 bit */
+    if (!fb->is_bgr) {
+        t = rgb[0]; rgb[0] = rgb[2];    rgb[2] = t;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// 표시중인 화면을 파일로 저장 (*.ppm : P6 RGB, 그 외 : native pixel raw)
+//-----------------------------------------------------------------------------
+bool fb_dump (fb_info_t *fb, const char *path)
+{
+    FILE *fp;
+    unsigned char *row, *src;
+    int x, y, len = strlen (path);
+    bool ppm = (len > 4) && !strcasecmp (path + len - 4, ".ppm");
+
+    if ((fp = fopen (path, "wb")) == NULL) {
+        err("%s open fail! (%s)\n", path, strerror(errno));
+        return false;
+    }
+    /* page flip을 사용하면 표시중인 page 기준 */
+    src = (unsigned char *)fb->dev + fb->page * fb->h * fb->stride;
+    if (!ppm) {
+        for (y = 0; y < fb->h; y++, src += fb->stride)
+            fwrite (src, fb->w * fb->p_size, 1, fp);
+        fclose (fp);
+        return true;
+    }
+    if ((row = (unsigned char *)malloc (fb->w * 3)) == NULL) {
+        err("dump row malloc error!\n");
+        fclose (fp);
+        return false;
+    }
+    fprintf (fp, "P6\n%d %d\n255\n", fb->w, fb->h);
+    for (y = 0; y < fb->h; y++, src += fb->stride) {
+        for (x = 0; x < fb->w; x++)
+            _fb_pixel_rgb (fb, src + x * fb->p_size, row + x * 3);
+        fwrite (row, fb->w * 3, 1, fp);
+    }
+    free (row);
+    fclose (fp);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// virtual 화면이 2 page 이상이면 page flip 사용 (driver가 지원하지 않으면 복사)
+//-----------------------------------------------------------------------------
+static void _fb_page_init (fb_info_t *fb, struct fb_var_screeninfo *fvsi,
+                            struct fb_fix_screeninfo *ffsi)
+{
+    struct fb_var_screeninfo v = *fvsi;
+    __u32 crtc = 0;
+
+    fb->page_cnt = 1;
+    fb->page     = 0;
+
+    /* shadow buffer가 없으면 back page를 만들 수 없음 */
+    if ((fb->data == fb->dev) ||
+        (ffsi->smem_len < (__u32)(fb->stride * fb->h * 2)) || !ffsi->ypanstep)
+        return;
+
+    if (v.yres_virtual < v.yres * 2) {
+        v.yres_virtual = v.yres * 2;
+        if ((ioctl (fb->fd, FBIOPUT_VSCREENINFO, &v) < 0) ||
+            (ioctl (fb->fd, FBIOGET_VSCREENINFO, &v) < 0) ||
+            (v.yres_virtual < v.yres * 2))
+            return;
     }
+    fb->page_cnt = 2;
+    fb->page     = (v.yoffset >= v.yres) ? 1 : 0;
+    fb->vsync    = (ioctl (fb->fd, FBIO_WAITFORVSYNC, &crtc) < 0) ? false : true;
+    info("framebuffer page flip enable. (vsync = %d)\n", fb->vsync);
 }
 
 //-----------------------------------------------------------------------------
 void fb_clear (fb_info_t *fb)
 {
-    memset(fb->data, 0x00, (fb->w * fb->h * fb->bpp) / 8);
+    memset(fb->data, 0x00, fb->stride * fb->h);
+    fb_dirty (fb, 0, 0, fb->w, fb->h);
 }
 
 //-----------------------------------------------------------------------------
 void fb_close (fb_info_t *fb)
 {
+    int i;
+
     if (fb) {
-        if (fb->fd)
+        /* 화면에 반영되지 않은 영역 */
+        if (fb->dev) {
+            fb_flush (fb);
+            if (fb->data != fb->dev)
+                free (fb->data);
+        }
+        if (fb->base)
+            munmap (fb->base, fb->base_size);
+        if (fb->gcache) {
+            for (i = 0; i < GLYPH_CACHE_COUNT; i++)
+                free (fb->gcache->slot[i].data);
+            free (fb->gcache);
+        }
+        if (fb->fd > 0)
             close (fb->fd);
         free (fb);
     }
 }
 
+//-----------------------------------------------------------------------------
+// framebuffer device가 없는 환경 (CI, benchmark)에서 사용하는 memory 화면
+// mem:{w}x{h}x{bpp}, file:{w}x{h}x{bpp}:{path} (bpp = 16, 24, 32, 생략시 32)
+//-----------------------------------------------------------------------------
+static fb_info_t *_fb_init_mem (const char *DEVICE_NAME)
+{
+    fb_info_t *fb;
+    bool is_file = !strncmp (DEVICE_NAME, "file:", strlen("file:"));
+    const char *p = strchr (DEVICE_NAME, ':') + 1;
+    char *end;
+    long w, h, bpp = 32;
+
+    w = strtol (p, &end, 10);
+    h = (*end == 'x') ? strtol (end + 1, &end, 10) : 0;
+    if (*end == 'x')
+        bpp = strtol (end + 1, &end, 10);
+
+    if ((w <= 0) || (h <= 0) || (w > 8192) || (h > 8192) ||
+        ((bpp != 16) && (bpp != 24) && (bpp != 32)) ||
+        (is_file ? ((*end != ':') || !end[1]) : (*end != 0))) {
+        err("%s : unsupported memory framebuffer!\n", DEVICE_NAME);
+        return NULL;
+    }
+
+    if ((fb = (fb_info_t *)malloc(sizeof(fb_info_t))) == NULL) {
+        err("framebuffer malloc error!\n");
+        return NULL;
+    }
+    memset(fb, 0, sizeof(fb_info_t));
+
+    fb->backend = is_file ? eFB_BACKEND_FILE : eFB_BACKEND_MEM;
+    if (is_file)
+        strncpy (fb->dump_path, end + 1, sizeof(fb->dump_path) - 1);
+
+    fb->w       = w;
+    fb->h       = h;
+    fb->bpp     = bpp;
+    fb->p_size  = bpp >> 3;
+    fb->stride  = w * fb->p_size;
+    fb->is_bgr  = true;
+    fb->format  = (bpp == 16) ? eFB_FORMAT_RGB565 :
+                  (bpp == 24) ? eFB_FORMAT_RGB888 : eFB_FORMAT_XRGB8888;
+    _fb_ops_select ();
+    fb->ops     = &FbOps[fb->format];
+    fb->page_cnt  = 1;
+    fb->base_size = fb->stride * fb->h;
+
+    /* memfd는 /proc/{pid}/fd/{fd}로 다른 process에서 화면을 볼 수 있음 */
+    fb->fd = -1;
+#if defined(MFD_CLOEXEC)
+    if ((fb->fd = memfd_create ("jig-fb", MFD_CLOEXEC)) >= 0) {
+        if (ftruncate (fb->fd, fb->base_size) < 0) {
+            close (fb->fd);
+            fb->fd = -1;
+        }
+    }
+#endif
+    fb->base = (char *)mmap (NULL, fb->base_size, PROT_READ | PROT_WRITE,
+                        (fb->fd < 0) ? (MAP_PRIVATE | MAP_ANONYMOUS) : MAP_SHARED,
+                        fb->fd, 0);
+    if (fb->base == (char *)-1) {
+        err("mmap");
+        fb->base = NULL;
+        fb_close (fb);
+        return NULL;
+    }
+    fb->dev  = fb->base;
+
+    /* file backend는 변경 영역이 있을 때만 저장하도록 shadow buffer 사용 */
+    fb->data = fb->dev;
+    if (is_file && ((fb->data = (char *)malloc (fb->stride * fb->h)) == NULL)) {
+        err("shadow buffer malloc error! (draw to device memory)\n");
+        fb->data = fb->dev;
+    }
+    info("memory framebuffer %dx%d, bpp = %d %s%s\n", fb->w, fb->h, fb->bpp,
+        is_file ? "dump = " : "", fb->dump_path);
+    fb_clear (fb);
+    return fb;
+}
+
 //-----------------------------------------------------------------------------
 fb_info_t *fb_init (const char *DEVICE_NAME)
 {
 	struct fb_var_screeninfo fvsi;
 	struct fb_fix_screeninfo ffsi;
-    
-    fb_info_t   *fb = (fb_info_t *)malloc(sizeof(fb_info_t));
+    fb_info_t   *fb;
+
+    /* framebuffer device가 없는 화면 */
+    if (!strncmp (DEVICE_NAME, "mem:",  strlen("mem:")) ||
+        !strncmp (DEVICE_NAME, "file:", strlen("file:")))
+        return _fb_init_mem (DEVICE_NAME);
+
+    fb = (fb_info_t *)malloc(sizeof(fb_info_t));
 
     if (fb == NULL) {
         err("framebuffer malloc error!\n");
@@ -368,21 +1172,45 @@ fb_info_t *fb_init (const char *DEVICE_NAME)
 	fb->h       = fvsi.yres;
 	fb->bpp     = fvsi.bits_per_pixel;
 	fb->stride  = ffsi.line_length;
+	fb->is_bgr  = (fvsi.red.offset > fvsi.blue.offset) ? true : false;
 
-	if (fvsi.red.length != 8 || fvsi.green.length != 8 || fvsi.blue.length != 8) {
-		err("mmap");
+    /* pixel format에 맞는 draw 함수 선택 */
+    if ((fb->bpp == 16) && (fvsi.red.length == 5) &&
+        (fvsi.green.length == 6) && (fvsi.blue.length == 5))
+        fb->format = eFB_FORMAT_RGB565;
+    else if ((fvsi.red.length == 8) && (fvsi.green.length == 8) && (fvsi.blue.length == 8) &&
+             ((fb->bpp == 24) || (fb->bpp == 32)))
+        fb->format = (fb->bpp == 24) ? eFB_FORMAT_RGB888 : eFB_FORMAT_XRGB8888;
+    else {
+		err("unsupported pixel format! (bpp = %d, rgb = %d/%d/%d)\n", fb->bpp,
+            fvsi.red.length, fvsi.green.length, fvsi.blue.length);
         goto out;
 	}
+    fb->p_size  = fb->bpp >> 3;
+    _fb_ops_select ();
+    fb->ops     = &FbOps[fb->format];
 
 	fb->base = (char *)mmap((caddr_t) NULL, ffsi.smem_len,
                         PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
 
 	if (fb->base == (char *)-1) {
 		err("mmap");
+        fb->base = NULL;
         goto out;
 	}
+    fb->base_size = ffsi.smem_len;
 
-    fb->data = fb->base + ((unsigned long) ffsi.smem_start % (unsigned long) getpagesize());
+    fb->dev  = fb->base + ((unsigned long) ffsi.smem_start % (unsigned long) getpagesize());
+
+    /*
+        device memory는 uncached인 경우가 많으므로 일반 memory에 그린 후
+        fb_flush에서 변경된 영역만 복사한다.
+    */
+    if ((fb->data = (char *)malloc (fb->stride * fb->h)) == NULL) {
+        err("shadow buffer malloc error! (draw to device memory)\n");
+        fb->data = fb->dev;
+    }
+    _fb_page_init (fb, &fvsi, &ffsi);
     fb_clear(fb);
     return  fb;
 out:
@@ -61,15 +61,81 @@ typedef union fb_color__u {
     unsigned int uint;
 }	fb_color_u;
 
+/* framebuffer pixel format (fb_init에서 결정) */
+enum eFB_FORMAT {
+    eFB_FORMAT_RGB565 = 0,
+    eFB_FORMAT_RGB888,
+    eFB_FORMAT_XRGB8888,
+    eFB_FORMAT_END
+};
+
+/*
+    화면 출력 방식 (FB 설정의 device 이름으로 선택)
+    /dev/fbN                    : framebuffer device
+    mem:{w}x{h}x{bpp}           : memory (화면 없이 ui 실행, benchmark)
+    file:{w}x{h}x{bpp}:{path}   : memory + fb_flush마다 path에 화면 저장 (.ppm 또는 raw)
+*/
+enum eFB_BACKEND {
+    eFB_BACKEND_DEV = 0,
+    eFB_BACKEND_MEM,
+    eFB_BACKEND_FILE,
+    eFB_BACKEND_END
+};
+
+#define FB_DUMP_PATH_MAX    128
+
+struct fb_info__t;
+struct glyph_cache__t;
+
+/* 변경된 화면 영역 (shadow buffer -> device 복사 단위) */
+#define FB_DIRTY_MAX    32
+
+typedef struct fb_rect__t {
+    int     x, y, w, h;
+}   fb_rect_t;
+
+/* pixel format별 draw 함수 (px = native pixel value) */
+typedef struct fb_ops__t {
+    /* clipping된 영역을 채움 */
+    void    (*fill)   (struct fb_info__t *fb, int x, int y, int w, int h, __u32 px);
+    /* 1bpp bitmap(msb first) n bits를 scale배 pixel로 확장 */
+    void    (*expand) (unsigned char *dst, const unsigned char *bits, int n,
+                        int scale, __u32 fg, __u32 bg);
+}   fb_ops_t;
+
 typedef struct fb_info__t {
 	int			fd;
 	int			w;
 	int			h;
 	int			stride;
 	int			bpp;
+	/* red channel이 상위 bit (little endian에서 B,G,R 순서) */
 	bool		is_bgr;
 	char		*base;
+	/* draw 대상 (shadow buffer, 할당 실패시 dev와 같음) */
 	char		*data;
+	/* device memory (mmap된 화면 시작 위치), base의 mmap 크기 */
+	char		*dev;
+	unsigned long	base_size;
+	/* fb_flush에서 device로 복사할 영역 */
+	fb_rect_t	dirty[FB_DIRTY_MAX];
+	int			dirty_cnt;
+	/* page flip (yres_virtual = 2 x yres) : page 수, 현재 표시중인 page */
+	int			page_cnt, page;
+	/* 이전 flush 영역 (back page는 2 frame 전의 화면) */
+	fb_rect_t	prev_dirty[FB_DIRTY_MAX];
+	int			prev_cnt;
+	/* FBIO_WAITFORVSYNC 지원 */
+	bool		vsync;
+	/* pixel format, pixel 크기(bytes) */
+	int			format;
+	int			p_size;
+	const fb_ops_t	*ops;
+	/* 화면 출력 방식, eFB_BACKEND_FILE의 저장 파일 */
+	int			backend;
+	char		dump_path[FB_DUMP_PATH_MAX];
+	/* 확장된 glyph pixel cache (draw_text에서 생성) */
+	struct glyph_cache__t	*gcache;
 }	fb_info_t;
 
 //-----------------------------------------------------------------------------
@@ -88,6 +154,7 @@ enum eFONTS_HANGUL {
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
+extern __u32        fb_pixel 	(fb_info_t *fb, int color);
 extern void         put_pixel 	(fb_info_t *fb, int x, int y, int color);
 extern void         draw_text 	(fb_info_t *fb, int x, int y,
 									int f_color, int b_color, int scale, char *fmt, ...);
@@ -95,6 +162,9 @@ extern void         draw_line 	(fb_info_t *fb, int x, int y, int w, int color);
 extern void         draw_rect 	(fb_info_t *fb, int x, int y, int w, int h, int lw, int color);
 extern void         draw_fill_rect (fb_info_t *fb, int x, int y, int w, int h, int color);
 extern void         set_font	(enum eFONTS_HANGUL s_font);
+extern void         fb_dirty 	(fb_info_t *fb, int x, int y, int w, int h);
+extern void         fb_flush 	(fb_info_t *fb);
+extern bool         fb_dump 	(fb_info_t *fb, const char *path);
 extern void         fb_clear 	(fb_info_t *fb);
 extern void         fb_close 	(fb_info_t *fb);
 extern fb_info_t    *fb_init 	(const char *DEVICE_NAME);
@@ -17,71 +17,294 @@
 //------------------------------------------------------------------------------
 // Linux headers
 //------------------------------------------------------------------------------
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include "lib_uart.h"
 
 //------------------------------------------------------------------------------
+// termios2 (asm/termbits.h는 termios.h와 같이 사용할 수 없으므로 직접 정의)
+// 표준 Bxxx 이외의 baud rate를 BOTHER로 설정하기 위하여 사용.
+//------------------------------------------------------------------------------
+#define KERNEL_NCCS     19
+
+#ifndef BOTHER
+#define BOTHER          0010000
+#endif
+#ifndef IBSHIFT
+#define IBSHIFT         16
+#endif
+
+struct termios2 {
+    tcflag_t    c_iflag;
+    tcflag_t    c_oflag;
+    tcflag_t    c_cflag;
+    tcflag_t    c_lflag;
+    cc_t        c_line;
+    cc_t        c_cc[KERNEL_NCCS];
+    speed_t     c_ispeed;
+    speed_t     c_ospeed;
+};
+
+//------------------------------------------------------------------------------
+bool        queue_init      (queue_t *q, __u32 size);
+void        queue_free      (queue_t *q);
+__u32       queue_count     (queue_t *q);
+__u32       queue_space     (queue_t *q);
 bool        queue_put       (queue_t *q, __u8 *d);
 bool        queue_get       (queue_t *q, __u8 *d);
+__u32       queue_get_n     (queue_t *q, __u8 *d, __u32 n);
+__u32       queue_put_n     (queue_t *q, const __u8 *d, __u32 n);
+__u32       queue_peek      (queue_t *q, __u8 **d);
+int         queue_peek_iov  (queue_t *q, struct iovec *iov);
+void        queue_drop      (queue_t *q, __u32 n);
 void        *rx_thread_func (void *arg);
 void        *tx_thread_func (void *arg);
 void        ptc_set_status  (ptc_grp_t *ptc_grp, __u8 ptc_num, bool status);
-void        ptc_q           (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 idata);
-void        ptc_event       (ptc_grp_t *ptc_grp, __u8 idata);
-bool        ptc_func_init   (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size, 
+static int  _ptc_flen       (ptc_func_t *ptc);
+static void _ptc_resync     (ptc_var_t *var);
+static __u32 _ptc_span      (ptc_func_t *ptc, const __u8 *data, __u32 size);
+static void _ptc_feed       (ptc_grp_t *ptc_grp, __u8 ptc_num,
+                                const __u8 *data, __u32 size);
+__u32       ptc_event       (ptc_grp_t *ptc_grp, const __u8 *data, __u32 size);
+bool        ptc_func_init   (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size,
+        __u8 ptc_head,
         int (*chk_func)(ptc_var_t *var), int (*cat_func)(ptc_var_t *var));
+void        ptc_func_len    (ptc_grp_t *ptc_grp, __u8 ptc_num,
+        int (*len_func)(ptc_var_t *var));
 bool        ptc_grp_init    (ptc_grp_t *ptc_grp, __u8 ptc_count);
 void        ptc_grp_close   (ptc_grp_t *ptc_grp);
+__u32       uart_send       (ptc_grp_t *ptc_grp, const __u8 *d, __u32 n);
+bool        uart_tx_drain   (ptc_grp_t *ptc_grp, int timeout_ms);
+bool        uart_set_baud   (ptc_grp_t *ptc_grp, __u32 baud);
 ptc_grp_t   *uart_init      (const char *dev_name, speed_t baud);
 void        uart_close      (ptc_grp_t *ptc_grp);
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
-bool queue_put (queue_t *q, __u8 *d)
+bool queue_init (queue_t *q, __u32 size)
 {
-    q->buf[q->ep++] = *d;
-    if (q->ep >= q->size)   q->ep = 0;
-    // queue overflow
-    if (q->ep == q->sp) {
-        q->sp++;
-        return false;
+    __u32 q_size = 1;
+
+    /* masking을 위하여 size는 2^n으로 올림 */
+    while (q_size < size)
+        q_size <<= 1;
+
+    q->ep   = 0;
+    q->sp   = 0;
+    q->size = q_size;
+    q->mask = q_size - 1;
+    q->buf  = (__u8 *)(malloc(q_size));
+
+    return (q->buf != NULL) ? true : false;
+}
+
+//------------------------------------------------------------------------------
+void queue_free (queue_t *q)
+{
+    if (q->buf)
+        free (q->buf);
+    q->buf = NULL;
+}
+
+//------------------------------------------------------------------------------
+// queue에 저장된 data 개수 (consumer에서 호출)
+//------------------------------------------------------------------------------
+__u32 queue_count (queue_t *q)
+{
+    return __atomic_load_n (&q->ep, __ATOMIC_ACQUIRE) -
+           __atomic_load_n (&q->sp, __ATOMIC_RELAXED);
+}
+
+//------------------------------------------------------------------------------
+// queue의 빈 공간 (producer에서 호출)
+//------------------------------------------------------------------------------
+__u32 queue_space (queue_t *q)
+{
+    return q->size - (__atomic_load_n (&q->ep, __ATOMIC_RELAXED) -
+                      __atomic_load_n (&q->sp, __ATOMIC_ACQUIRE));
+}
+
+//------------------------------------------------------------------------------
+__u32 queue_put_n (queue_t *q, const __u8 *d, __u32 n)
+{
+    __u32 ep = __atomic_load_n (&q->ep, __ATOMIC_RELAXED);
+    __u32 sp = __atomic_load_n (&q->sp, __ATOMIC_ACQUIRE);
+    __u32 pos, len;
+
+    /* queue overflow : 남은 공간만큼만 저장 (consumer index는 건드리지 않음) */
+    if (n > q->size - (ep - sp))
+        n = q->size - (ep - sp);
+
+    pos = ep & q->mask;
+    len = (n > (q->size - pos)) ? (q->size - pos) : n;
+    memcpy (&q->buf[pos], d, len);
+    memcpy (&q->buf[0], d + len, n - len);
+
+    __atomic_store_n (&q->ep, ep + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+//------------------------------------------------------------------------------
+__u32 queue_get_n (queue_t *q, __u8 *d, __u32 n)
+{
+    __u32 sp = __atomic_load_n (&q->sp, __ATOMIC_RELAXED);
+    __u32 ep = __atomic_load_n (&q->ep, __ATOMIC_ACQUIRE);
+    __u32 pos, len;
+
+    if (n > (ep - sp))
+        n = ep - sp;
+
+    pos = sp & q->mask;
+    len = (n > (q->size - pos)) ? (q->size - pos) : n;
+    memcpy (d, &q->buf[pos], len);
+    memcpy (d + len, &q->buf[0], n - len);
+
+    __atomic_store_n (&q->sp, sp + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+//------------------------------------------------------------------------------
+// 연속된 읽기 영역의 포인터와 크기를 얻음 (copy 없이 사용 후 queue_drop 호출)
+//------------------------------------------------------------------------------
+__u32 queue_peek (queue_t *q, __u8 **d)
+{
+    __u32 sp = __atomic_load_n (&q->sp, __ATOMIC_RELAXED);
+    __u32 ep = __atomic_load_n (&q->ep, __ATOMIC_ACQUIRE);
+    __u32 pos = sp & q->mask;
+
+    *d = &q->buf[pos];
+    return ((ep - sp) > (q->size - pos)) ? (q->size - pos) : (ep - sp);
+}
+
+//------------------------------------------------------------------------------
+// 읽기 영역 전체를 iovec(최대 2개)로 얻음 (writev 용, 사용 후 queue_drop 호출)
+//------------------------------------------------------------------------------
+int queue_peek_iov (queue_t *q, struct iovec *iov)
+{
+    __u32 sp = __atomic_load_n (&q->sp, __ATOMIC_RELAXED);
+    __u32 ep = __atomic_load_n (&q->ep, __ATOMIC_ACQUIRE);
+    __u32 pos = sp & q->mask, len = ep - sp;
+
+    if (!len)
+        return 0;
+
+    iov[0].iov_base = &q->buf[pos];
+    if (len <= (q->size - pos)) {
+        iov[0].iov_len  = len;
+        return 1;
     }
-    return  true;
+    iov[0].iov_len  = q->size - pos;
+    iov[1].iov_base = &q->buf[0];
+    iov[1].iov_len  = len - (q->size - pos);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+void queue_drop (queue_t *q, __u32 n)
+{
+    __atomic_store_n (&q->sp, __atomic_load_n (&q->sp, __ATOMIC_RELAXED) + n,
+                        __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+bool queue_put (queue_t *q, __u8 *d)
+{
+    return queue_put_n (q, d, 1) ? true : false;
 }
 
 //------------------------------------------------------------------------------
 bool queue_get (queue_t *q, __u8 *d)
 {
-    if (q->ep != q->sp) {
-        *d = q->buf[q->sp++];
-        if (q->sp >= q->size)   q->sp = 0;
-        return  true;
-    }
-    // queue empty
-    return false;
+    return queue_get_n (q, d, 1) ? true : false;
 }
 
 //------------------------------------------------------------------------------
 void *rx_thread_func (void *arg)
 {
-    __u8 d;
+    __u8 buf[UART_RX_BUF_SIZE];
+    int len;
     ptc_grp_t *ptc_grp = (ptc_grp_t *)arg;
+    struct pollfd pfd;
+
+    pfd.fd     = ptc_grp->fd;
+    pfd.events = POLLIN;
 
     while(true) {
-        if (read (ptc_grp->fd, &d, 1))      queue_put (&ptc_grp->rx_q, &d);
-        usleep(50);
+        /* line idle : thread sleep (no timeout) */
+        if (poll (&pfd, 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            err ("rx poll error! (%s)\n", strerror(errno));
+            break;
+        }
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            err ("uart device closed! (revents = 0x%x)\n", pfd.revents);
+            break;
+        }
+        /*
+            VMIN = 0, VTIME = 0 이므로 read는 block되지 않고
+            tty에 쌓여있는 data를 한번에 모두 가져온다.
+        */
+        while ((len = read (ptc_grp->fd, buf, sizeof(buf))) > 0) {
+            if (queue_put_n (&ptc_grp->rx_q, buf, len) != (__u32)len)
+                err ("rx queue overflow!\n");
+            if (len < (int)sizeof(buf))
+                break;
+        }
+        /* wakeup 당 1회 수신 알림 */
+        if (queue_count (&ptc_grp->rx_q))
+            eventfd_write (ptc_grp->rx_efd, 1);
     }
+    return NULL;
 }
 
 //------------------------------------------------------------------------------
 void *tx_thread_func (void *arg)
 {
-    __u8 d;
     ptc_grp_t *ptc_grp = (ptc_grp_t *)arg;
+    struct pollfd pfd[2];
+    struct iovec iov[2];
+    eventfd_t cnt;
+    ssize_t len;
+    int iov_cnt;
+
+    /* pfd[0] : uart_send wakeup, pfd[1] : tty write 가능(POLLOUT) */
+    pfd[0].fd     = ptc_grp->tx_efd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd     = ptc_grp->fd;
+    pfd[1].events = 0;
 
     while(true) {
-        if (queue_get(&ptc_grp->tx_q, &d))   write (ptc_grp->fd, &d, 1);
-        usleep(50);
+        if (poll (pfd, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            err ("tx poll error! (%s)\n", strerror(errno));
+            break;
+        }
+        if (pfd[1].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            err ("uart device closed! (revents = 0x%x)\n", pfd[1].revents);
+            break;
+        }
+        /* event clear는 queue를 비우기 전에 해야 wakeup을 놓치지 않는다. */
+        if (pfd[0].revents & POLLIN)
+            eventfd_read (ptc_grp->tx_efd, &cnt);
+
+        /* queue에 있는 연속된 영역을 모두 한번의 writev로 전송 */
+        while ((iov_cnt = queue_peek_iov (&ptc_grp->tx_q, iov)) > 0) {
+            if ((len = writev (ptc_grp->fd, iov, iov_cnt)) < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN)
+                    err ("uart write error! (%s)\n", strerror(errno));
+                break;
+            }
+            queue_drop (&ptc_grp->tx_q, len);
+        }
+        /* tty buffer가 가득 찬 경우 write 가능할 때까지 대기 */
+        pfd[1].events = queue_count (&ptc_grp->tx_q) ? POLLOUT : 0;
     }
+    return NULL;
 }
 
 //------------------------------------------------------------------------------
@@ -93,47 +316,144 @@ void ptc_set_status (ptc_grp_t *ptc_grp, __u8 ptc_num, bool status)
 }
 
 //------------------------------------------------------------------------------
-// data save to protocol q
+// 현재 수신중인 frame의 길이 (0 = header 수신중, -1 = 잘못된 frame)
 //------------------------------------------------------------------------------
-void ptc_q (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 idata)
+static int _ptc_flen (ptc_func_t *ptc)
 {
-	ptc_grp->p[ptc_num].var.p_ep %= ptc_grp->p[ptc_num].var.size;
-	if (ptc_grp->p[ptc_num].var.p_ep == ptc_grp->p[ptc_num].var.p_sp)
-	{
-		ptc_grp->p[ptc_num].var.p_sp++;
-		ptc_grp->p[ptc_num].var.p_sp %= ptc_grp->p[ptc_num].var.size;
-	}
-	ptc_grp->p[ptc_num].var.buf[ptc_grp->p[ptc_num].var.p_ep++] = idata;
+    int flen;
+
+    if (ptc->plen == NULL)
+        return ptc->var.size;
+
+    flen = ptc->plen (&ptc->var);
+    return (flen > (int)ptc->var.size) ? -1 : flen;
 }
 
 //------------------------------------------------------------------------------
-//   Protocol check & data atch fron Q Buffer
+// 잘못된 frame : buffer안의 다음 head byte부터 다시 동기화
 //------------------------------------------------------------------------------
-void ptc_event (ptc_grp_t *ptc_grp, __u8 idata)
+static void _ptc_resync (ptc_var_t *var)
 {
-    __u8 ptc_pos;
+    __u8 *p;
+
+    var->err_cnt++;
+
+    if ((var->len > 1) &&
+        (p = memchr (&var->buf[1], var->head, var->len - 1)) != NULL) {
+        var->len = var->len - (__u32)(p - var->buf);
+        memmove (var->buf, p, var->len);
+    }
+    else
+        var->len = 0;
+}
+
+//------------------------------------------------------------------------------
+// frame 판단(pcheck) 시점까지 protocol이 받아들일 수 있는 최대 data 크기
+//------------------------------------------------------------------------------
+static __u32 _ptc_span (ptc_func_t *ptc, const __u8 *data, __u32 size)
+{
+    ptc_var_t   *var = &ptc->var;
+    const __u8  *p;
+    int         flen;
+
+    if (var->len) {
+        flen = _ptc_flen (ptc);
+        return (flen > (int)var->len) ? (__u32)flen - var->len : 1;
+    }
 
-	for (ptc_pos = 0; ptc_pos < ptc_grp->pcnt; ptc_pos++)	{
-		if (ptc_grp->p[ptc_pos].var.open)	{
-			ptc_q (ptc_grp, ptc_pos, idata);
-			if (ptc_grp->p[ptc_pos].pcheck (&ptc_grp->p[ptc_pos].var))	{
-				if (ptc_grp->p[ptc_pos].pcatch (&ptc_grp->p[ptc_pos].var))	{
-                    ptc_grp->p[ptc_pos].var.pass = true;
-					ptc_set_status (ptc_grp, ptc_pos, false);
-				}
-			}
-		}
-	}
+    /* frame head가 없으면 모두 버림 */
+    if ((p = memchr (data, var->head, size)) == NULL)
+        return size;
+
+    /* 가변 길이 frame은 header를 받아야 길이를 알 수 있음 */
+    return (__u32)(p - data) + (ptc->plen ? 1 : var->size);
+}
+
+//------------------------------------------------------------------------------
+// rx data를 protocol buffer에 저장하고 frame이 완성되면 check & catch
+//------------------------------------------------------------------------------
+static void _ptc_feed (ptc_grp_t *ptc_grp, __u8 ptc_num,
+                        const __u8 *data, __u32 size)
+{
+    ptc_func_t  *ptc = &ptc_grp->p[ptc_num];
+    ptc_var_t   *var = &ptc->var;
+    const __u8  *p;
+    __u32       len;
+    int         flen;
+
+    while (size) {
+        /* frame 시작 전이면 head byte를 찾는다 */
+        if (!var->len) {
+            if ((p = memchr (data, var->head, size)) == NULL)
+                return;
+            size -= (__u32)(p - data);
+            data  = p;
+        }
+
+        /* frame 길이를 모르면(header 수신중) 1 byte씩 받는다 */
+        flen = _ptc_flen (ptc);
+        len  = ((flen > (int)var->len) ? (__u32)flen : var->len + 1) - var->len;
+        len  = (size > len) ? len : size;
+        memcpy (&var->buf[var->len], data, len);
+        var->len += len;
+        data     += len;
+        size     -= len;
+
+        while (var->len) {
+            if (((flen = _ptc_flen (ptc)) == 0) || ((int)var->len < flen))
+                break;
+
+            if ((flen > 0) && ptc->pcheck (var) && ptc->pcatch (var)) {
+                var->len  = 0;
+                var->pass = true;
+                ptc_set_status (ptc_grp, ptc_num, false);
+                return;
+            }
+            _ptc_resync (var);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//   Protocol check & data catch from rx data
+//   open되어있는 모든 protocol에 같은 data를 전달하며, frame이 완성(pass)되면
+//   그 위치에서 멈춘다. (return : 처리한 data 크기)
+//------------------------------------------------------------------------------
+__u32 ptc_event (ptc_grp_t *ptc_grp, const __u8 *data, __u32 size)
+{
+    __u32 used = 0, chunk, span;
+    __u8 ptc_pos;
+    bool pass = false;
+
+    while ((used < size) && !pass) {
+        /* 어떤 protocol도 frame 판단을 하지 않는 최대 크기 */
+        chunk = size - used;
+        for (ptc_pos = 0; ptc_pos < ptc_grp->pcnt; ptc_pos++) {
+            if (ptc_grp->p[ptc_pos].var.open) {
+                span = _ptc_span (&ptc_grp->p[ptc_pos], data + used, size - used);
+                chunk = (span < chunk) ? span : chunk;
+            }
+        }
+        for (ptc_pos = 0; ptc_pos < ptc_grp->pcnt; ptc_pos++) {
+            if (ptc_grp->p[ptc_pos].var.open) {
+                _ptc_feed (ptc_grp, ptc_pos, data + used, chunk);
+                pass = ptc_grp->p[ptc_pos].var.pass ? true : pass;
+            }
+        }
+        used += chunk;
+    }
+    return used;
 }
 
 //------------------------------------------------------------------------------
 //   UART Protocol Initiliaze Function
 //------------------------------------------------------------------------------
-bool ptc_func_init (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size, 
+bool ptc_func_init (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size,
+    __u8 ptc_head,
     int (*chk_func)(ptc_var_t *var), int (*cat_func)(ptc_var_t *var))
 {
-    ptc_grp->p[ptc_num].var.p_ep = 0;
-    ptc_grp->p[ptc_num].var.p_sp = 0;
+    ptc_grp->p[ptc_num].var.len  = 0;
+    ptc_grp->p[ptc_num].var.head = ptc_head;
     ptc_grp->p[ptc_num].var.open = 1;
     ptc_grp->p[ptc_num].var.pass = 0;
 
@@ -150,6 +470,15 @@ bool ptc_func_init (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size,
     return true;
 }
 
+//------------------------------------------------------------------------------
+// 가변 길이 frame protocol 설정 (ptc_size는 최대 frame 크기가 된다)
+//------------------------------------------------------------------------------
+void ptc_func_len (ptc_grp_t *ptc_grp, __u8 ptc_num,
+    int (*len_func)(ptc_var_t *var))
+{
+    ptc_grp->p[ptc_num].plen = len_func;
+}
+
 //------------------------------------------------------------------------------
 bool ptc_grp_init (ptc_grp_t *ptc_grp, __u8 ptc_count)
 {
@@ -172,27 +501,79 @@ void ptc_grp_close (ptc_grp_t *ptc_grp)
 {
     __u8 ptc_pos;
 
-    /* destroy pthread for tx / rx */
-    {
-        int ret;
-        ret = pthread_detach(ptc_grp->rx_thread);
-        info ("rx thread detach = %d\n", ret);
-        ret = pthread_detach(ptc_grp->tx_thread);
-        info ("tx thread detach = %d\n", ret);
+    /* destroy pthread for tx / rx (poll에서 대기중이므로 cancel 후 종료 대기) */
+    if (ptc_grp->p != NULL) {
+        pthread_cancel (ptc_grp->rx_thread);
+        pthread_cancel (ptc_grp->tx_thread);
+        pthread_join (ptc_grp->rx_thread, NULL);
+        pthread_join (ptc_grp->tx_thread, NULL);
     }
 
 	for (ptc_pos = 0; ptc_pos < ptc_grp->pcnt; ptc_pos++)
         free (ptc_grp->p[ptc_pos].var.buf);
 
     free (ptc_grp->p);
+    queue_free (&ptc_grp->tx_q);
+    queue_free (&ptc_grp->rx_q);
     free (ptc_grp);
 }
 //------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+// tx queue에 data를 넣고 tx thread를 깨운다.
+// protocol frame이 잘리지 않도록 공간이 부족하면 저장하지 않는다. (return : 저장된 크기)
+//------------------------------------------------------------------------------
+__u32 uart_send (ptc_grp_t *ptc_grp, const __u8 *d, __u32 n)
+{
+    __u32 q_size = 0;
+
+    if (queue_space (&ptc_grp->tx_q) >= n)
+        q_size = queue_put_n (&ptc_grp->tx_q, d, n);
+
+    if (q_size)
+        eventfd_write (ptc_grp->tx_efd, 1);
+    return q_size;
+}
+
+//------------------------------------------------------------------------------
+// tx queue와 tty 출력 buffer가 모두 전송될 때까지 대기 (baud 변경 전 사용)
+//------------------------------------------------------------------------------
+bool uart_tx_drain (ptc_grp_t *ptc_grp, int timeout_ms)
+{
+    while (queue_count (&ptc_grp->tx_q)) {
+        if (timeout_ms-- <= 0)
+            return false;
+        usleep (1000);
+    }
+    return tcdrain (ptc_grp->fd) ? false : true;
+}
+
+//------------------------------------------------------------------------------
+// termios2/BOTHER를 사용하여 임의의 baud rate(bps)로 변경
+//------------------------------------------------------------------------------
+bool uart_set_baud (ptc_grp_t *ptc_grp, __u32 baud)
+{
+    struct termios2 tio;
+
+    if (ioctl (ptc_grp->fd, TCGETS2, &tio) < 0) {
+        err ("Error %i from TCGETS2: %s\n", errno, strerror(errno));
+        return false;
+    }
+    tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = baud;
+    tio.c_ospeed = baud;
+
+    if (ioctl (ptc_grp->fd, TCSETS2, &tio) < 0) {
+        err ("Error %i from TCSETS2: %s\n", errno, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
 ptc_grp_t *uart_init (const char *dev_name, speed_t baud)
 {
     int fd;
-    unsigned char buf;
     // Create new termios struct, we call it 'tty' for convention
     struct termios tty;
 
@@ -231,7 +612,8 @@ ptc_grp_t *uart_init (const char *dev_name, speed_t baud)
     // tty.c_oflag &= ~ONOEOT; // Prevent removal of C-d chars (0x004) in output (NOT PRESENT ON LINUX)
 
     //tty.c_cc[VTIME] = 10;    // Wait for up to 1s (10 deciseconds), returning as soon as any data is received.
-    tty.c_cc[VTIME] = 0;    
+    // rx thread waits in poll(), read() returns immediately with all buffered data.
+    tty.c_cc[VTIME] = 0;
     tty.c_cc[VMIN] = 0;
     
     // Set in/out baud rate to be 115200
@@ -244,40 +626,52 @@ ptc_grp_t *uart_init (const char *dev_name, speed_t baud)
         close(fd);
         return NULL;
     }
-    while(read(fd, &buf, 1));    // read all if there is data in the serial rx buffer
+    tcflush(fd, TCIFLUSH);      // discard all if there is data in the serial rx buffer
+
+    // tx thread waits POLLOUT when the tty buffer is full.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
 
-    /* UART control struct init */
-    if ((ptc_grp = (ptc_grp_t *)(malloc(sizeof(ptc_grp_t)))) != NULL) {
+    /* UART control struct init (queue index는 cache line 정렬이 필요함) */
+    if (!posix_memalign((void **)&ptc_grp, QUEUE_CACHE_LINE, sizeof(ptc_grp_t))) {
         memset (ptc_grp, 0x00, sizeof(ptc_grp_t));
         ptc_grp->fd         = fd;
+        ptc_grp->tx_efd     = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ptc_grp->rx_efd     = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
 
-        ptc_grp->tx_q.sp    = 0;
-        ptc_grp->tx_q.ep    = 0;
-        ptc_grp->tx_q.size  = DEFAULT_QUEUE_SIZE;
-        ptc_grp->tx_q.buf   = (__u8 *)(malloc(DEFAULT_QUEUE_SIZE));
-
-        ptc_grp->rx_q.sp    = 0;
-        ptc_grp->rx_q.ep    = 0;
-        ptc_grp->rx_q.size  = DEFAULT_QUEUE_SIZE;
-        ptc_grp->rx_q.buf   = (__u8 *)(malloc(DEFAULT_QUEUE_SIZE));
-
-        if ((ptc_grp->tx_q.buf == NULL) || (ptc_grp->rx_q.buf == NULL)) {
+        if (!queue_init (&ptc_grp->tx_q, DEFAULT_QUEUE_SIZE) ||
+            !queue_init (&ptc_grp->rx_q, DEFAULT_QUEUE_SIZE) ||
+            (ptc_grp->tx_efd < 0) || (ptc_grp->rx_efd < 0)) {
             err ("rx/tx queue create error!\n");
+            queue_free (&ptc_grp->tx_q);
+            queue_free (&ptc_grp->rx_q);
+            if (ptc_grp->tx_efd >= 0)
+                close (ptc_grp->tx_efd);
+            if (ptc_grp->rx_efd >= 0)
+                close (ptc_grp->rx_efd);
             free (ptc_grp);
+            close (fd);
             return NULL;
         }
         return ptc_grp;
     }
+    close (fd);
     return NULL;
 }
 
 //------------------------------------------------------------------------------
 void uart_close (ptc_grp_t *ptc_grp)
 {
-    if (ptc_grp->fd)
-        close(ptc_grp->fd);
+    int fd = ptc_grp->fd, tx_efd = ptc_grp->tx_efd, rx_efd = ptc_grp->rx_efd;
 
+    /* tx/rx thread가 종료된 후 fd를 닫는다. */
     ptc_grp_close (ptc_grp);
+
+    if (fd)
+        close(fd);
+    if (tx_efd > 0)
+        close(tx_efd);
+    if (rx_efd > 0)
+        close(rx_efd);
 }
 
 //------------------------------------------------------------------------------
@@ -19,25 +19,45 @@
 #include <pthread.h>
 #include <termios.h>    // Contains POSIX terminal control definitions
 #include <unistd.h>     // write(), read(), close()
+#include <sys/uio.h>    // writev(), struct iovec
 #include "typedefs.h"
 
 //------------------------------------------------------------------------------
 #define DEFAULT_QUEUE_SIZE      1024
+/* rx thread read() buffer size (one wakeup drains up to this size per read) */
+#define UART_RX_BUF_SIZE        256
+
+#define QUEUE_CACHE_LINE        64
 
 //------------------------------------------------------------------------------
+/*
+    Lock-free single producer / single consumer ring buffer.
+    ep(head)는 producer만, sp(tail)는 consumer만 수정한다.
+    index는 free-running 값이며 size(2^n)로 masking 하여 사용한다.
+*/
 typedef struct queue__t {
-    __u32   sp;
-    __u32   ep;
     __u32   size;
+    __u32   mask;
     __u8    *buf;
-}   queue_t;
+    /* producer index (release store, consumer에서 acquire load) */
+    __u32   ep  __attribute__((aligned(QUEUE_CACHE_LINE)));
+    /* consumer index (release store, producer에서 acquire load) */
+    __u32   sp  __attribute__((aligned(QUEUE_CACHE_LINE)));
+}   __attribute__((aligned(QUEUE_CACHE_LINE))) queue_t;
 
+/*
+    protocol frame 수신 buffer (linear).
+    buf[0]은 항상 frame head(head byte)이며 frame 길이 만큼 수신되면 pcheck/pcatch 호출.
+    frame 길이는 size(고정 길이) 또는 plen 함수(가변 길이, size = 최대 frame 크기)로 결정.
+*/
 typedef struct protocol_variable__t {
-	__u32	p_sp;
-	__u32	p_ep;
+	__u32	len;
 	__u32	size;
+	__u8	head;
 	bool	open;
 	bool	pass;
+	/* 잘못된 frame 수신 횟수 (link error 판단용) */
+	__u32	err_cnt;
 	__u8	*buf;
 }   ptc_var_t;
 
@@ -45,10 +65,16 @@ typedef struct protocol_function__t {
     ptc_var_t   var;
     int         (*pcheck)(ptc_var_t *p);
     int         (*pcatch)(ptc_var_t *p);
+    /* 가변 길이 frame (return : frame 길이, 0 = header 수신중, -1 = 잘못된 header) */
+    int         (*plen)(ptc_var_t *p);
 }   ptc_func_t;
 
 typedef struct protocol_group__t {
     int         fd;
+    /* tx thread wakeup (uart_send에서 signal) */
+    int         tx_efd;
+    /* rx data 수신 알림 (rx thread에서 signal, server epoll에 등록) */
+    int         rx_efd;
     __u8        pcnt;
 	ptc_func_t  *p;
     pthread_t   rx_thread, tx_thread;
@@ -56,16 +82,30 @@ typedef struct protocol_group__t {
 }   ptc_grp_t;
 
 //------------------------------------------------------------------------------
+extern  bool        queue_init      (queue_t *q, __u32 size);
+extern  void        queue_free      (queue_t *q);
+extern  __u32       queue_count     (queue_t *q);
+extern  __u32       queue_space     (queue_t *q);
 extern  bool        queue_get       (queue_t *q, __u8 *d);
 extern  bool        queue_put       (queue_t *q, __u8 *d);
+extern  __u32       queue_get_n     (queue_t *q, __u8 *d, __u32 n);
+extern  __u32       queue_put_n     (queue_t *q, const __u8 *d, __u32 n);
+extern  __u32       queue_peek      (queue_t *q, __u8 **d);
+extern  int         queue_peek_iov  (queue_t *q, struct iovec *iov);
+extern  void        queue_drop      (queue_t *q, __u32 n);
 extern  void        ptc_set_status  (ptc_grp_t *ptc_grp, __u8 ptc_num, bool status);
-extern  void        ptc_q           (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 idata);
-extern  void        ptc_event       (ptc_grp_t *ptc_grp, __u8 idata);
-extern  bool        ptc_func_init   (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size, 
+extern  __u32       ptc_event       (ptc_grp_t *ptc_grp, const __u8 *data, __u32 size);
+extern  bool        ptc_func_init   (ptc_grp_t *ptc_grp, __u8 ptc_num, __u8 ptc_size,
+                __u8 ptc_head,
                 int (*chk_func)(ptc_var_t *var), int (*cat_func)(ptc_var_t *var));
+extern  void        ptc_func_len    (ptc_grp_t *ptc_grp, __u8 ptc_num,
+                int (*len_func)(ptc_var_t *var));
 extern  bool        ptc_grp_init    (ptc_grp_t *ptc_grp, __u8 ptc_count);
 extern  void        ptc_grp_close   (ptc_grp_t *ptc_grp);
 //------------------------------------------------------------------------------
+extern  __u32       uart_send       (ptc_grp_t *ptc_grp, const __u8 *d, __u32 n);
+extern  bool        uart_tx_drain   (ptc_grp_t *ptc_grp, int timeout_ms);
+extern  bool        uart_set_baud   (ptc_grp_t *ptc_grp, __u32 baud);
 extern  ptc_grp_t   *uart_init      (const char *dev_name, speed_t baud);
 extern  void        uart_close      (ptc_grp_t *ptc_grp);
 
@@ -26,23 +26,81 @@
 #include <sys/mman.h>
 #include <linux/fb.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
 
 #include "lib_ui.h"
 
+//------------------------------------------------------------------------------
+// Render thread (ui_post_* 요청을 item id 별로 합쳐서 frame 단위로 그림)
+//------------------------------------------------------------------------------
+/* ui_cmd_t flags */
+#define  UI_CMD_RITEM      0x01  /* ui_set_ritem */
+#define  UI_CMD_SCOLOR     0x02  /* string fc, bc */
+#define  UI_CMD_SITEM_STR  0x04  /* ui_set_sitem string */
+#define  UI_CMD_STR        0x08  /* ui_set_str */
+#define  UI_CMD_UPDATE     0x10  /* ui_update */
+
+typedef struct ui_cmd__t {
+   int   id, flags;
+   /* -1 = 변경 없음 */
+   int   r_bc, r_lc, s_fc, s_bc;
+   /* ui_set_str 인자 */
+   int   x, y, scale, font;
+   char  str[ITEM_STR_MAX];
+   /* ui_set_sitem 문자열 (ui_set_str 이후의 요청은 위치/배율을 유지해야 함) */
+   char  s_str[ITEM_STR_MAX];
+}  ui_cmd_t;
+
+typedef struct ui_render__t {
+   fb_info_t         *fb;
+   ui_grp_t          *ui_grp;
+   pthread_t         thread;
+   pthread_mutex_t   mutex;
+   /* 대기중인 요청이 생기면 render thread를 깨움 */
+   int               e_fd;
+   bool              stop;
+   /* frame 간격(us), 그린 frame 수 */
+   __u64             frame_us;
+   __u32             frames;
+   /*
+      대기중인 요청(cmd)과 그리는 중인 요청(draw), frame마다 서로 바꿈
+      id_max  = 서로 다른 id 수 (r_item id + 추가 s_item id)
+      cmd_max = id_max * 2 (같은 id의 ui_post_str을 합칠 수 없는 경우 따로 등록)
+   */
+   int               cmd_cnt, cmd_max, id_max;
+   ui_cmd_t          *cmd, *draw;
+}  ui_render_t;
+
 //------------------------------------------------------------------------------
 // Function prototype.
 //------------------------------------------------------------------------------
+static   void        _ui_index_list    (int *head, int *next, int idx);
+static   void        _ui_build_index   (ui_grp_t *ui_grp);
 static   r_item_t    *_ui_find_r_item  (ui_grp_t *ui_grp, int *sid, int fid);
 static   s_item_t    *_ui_find_s_item  (ui_grp_t *ui_grp, int *sid, int fid);
 
 static   int         _my_strlen        (char *str);
 static   int         _ui_str_scale     (int w, int h, int lw, int slen);
+static   int         _ui_auto_scale    (r_item_t *r_item, s_item_t *s_item, int slen);
 static   void        _ui_str_pos_xy    (r_item_t *r_item, s_item_t *s_item);
 static   void        _ui_clr_str       (fb_info_t *fb, r_item_t *r_item, s_item_t *s_item);
 static   void        _ui_update_r      (fb_info_t *fb, r_item_t *r_item);
 static   void        _ui_update_s      (fb_info_t *fb, s_item_t *s_item, int x, int y);
+static   int         _ui_glyph_len     (const char *p);
+static   void        _ui_draw_run      (fb_info_t *fb, s_item_t *s_item,
+                                          const char *run, int len, int x, int y);
+static   bool        _ui_update_s_diff (fb_info_t *fb, ui_grp_t *ui_grp, r_item_t *r_item,
+                                          s_item_t *s_item, char *str, int slen, int x, int y);
 static   void        _ui_update_extra  (fb_info_t *fb, ui_grp_t *ui_grp, int id);
 static   void        _ui_update        (fb_info_t *fb, ui_grp_t *ui_grp, int id);
+static   bool        _ui_ritem_changed (ui_grp_t *ui_grp, int f_id, int bc, int lc);
+static   bool        _ui_sitem_changed (ui_grp_t *ui_grp, int id, int fc, int bc, char *str);
+static   bool        _ui_str_changed   (ui_grp_t *ui_grp, int id, int x, int y,
+                                          int scale, int font, char *str, int slen);
+static   bool        _ui_group_ok      (int sid, int r_cnt, int g_cnt);
+static   bool        _ui_count_items   (FILE *pfd, int *r_max, int *s_max, int *id_cnt);
+static   ui_grp_t    *_ui_alloc        (int r_max, int s_max, int id_cnt);
 static   void        _ui_parser_cmd_C  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
 static   void        _ui_parser_cmd_R  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
 static   void        _ui_parser_cmd_S  (char *buf, fb_info_t *fb, ui_grp_t *ui_grp);
@@ -57,6 +115,22 @@ static   void        _ui_parser_cmd_G  (char *buf, fb_info_t *fb, ui_grp_t *ui_g
          void        ui_set_printf     (fb_info_t *fb, ui_grp_t *ui_grp,
                                  int id, char *fmt, ...);
          void        ui_update         (fb_info_t *fb, ui_grp_t *ui_grp, int id);
+
+static   __u64       _ui_time_us       (void);
+static   ui_cmd_t    *_ui_post_new     (ui_render_t *r, int id);
+static   ui_cmd_t    *_ui_post_get     (ui_render_t *r, int id);
+static   bool        _ui_post_str_merge(ui_cmd_t *cmd, int x, int y, int scale);
+static   void        _ui_post_done     (ui_render_t *r);
+         void        ui_post_ritem     (ui_grp_t *ui_grp, int f_id, int bc, int lc);
+         void        ui_post_sitem     (ui_grp_t *ui_grp, int id, int fc, int bc, char *str);
+         void        ui_post_str       (ui_grp_t *ui_grp,
+                                 int id, int x, int y, int scale, int font, char *fmt, ...);
+         void        ui_post_printf    (ui_grp_t *ui_grp, int id, char *fmt, ...);
+         void        ui_post_update    (ui_grp_t *ui_grp, int id);
+static   void        _ui_render_cmd    (fb_info_t *fb, ui_grp_t *ui_grp, ui_cmd_t *cmd);
+static   void        *_ui_render_thread(void *arg);
+         bool        ui_render_start   (fb_info_t *fb, ui_grp_t *ui_grp, int fps);
+static   void        _ui_render_stop   (ui_render_t *r);
          void        ui_close          (ui_grp_t *ui_grp);
          ui_grp_t    *ui_init          (fb_info_t *fb, const char *cfg_filename);
 
@@ -80,22 +154,55 @@ static   void        _ui_parser_cmd_G  (char *buf, fb_info_t *fb, ui_grp_t *ui_g
 */
 
 //------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void _ui_index_list (int *head, int *next, int idx)
+{
+   /* 뒤에서부터 등록하므로 list는 index 순서가 된다. */
+   next[idx] = *head;
+   *head     = idx;
+}
+
+//------------------------------------------------------------------------------
+// 같은 id의 r_item, s_item을 list로 연결 (config parsing 완료 후 한번 생성)
+//------------------------------------------------------------------------------
+static void _ui_build_index (ui_grp_t *ui_grp)
+{
+   int i, id;
+
+   for (i = 0; i < ui_grp->id_cnt; i++)
+      ui_grp->r_head[i] = ui_grp->s_head[i] = -1;
+   ui_grp->s_extra = -1;
+
+   /* r_item id는 parser에서 0 ~ id_cnt-1 로 제한됨 */
+   for (i = ui_grp->r_cnt - 1; i >= 0; i--)
+      _ui_index_list (&ui_grp->r_head[ui_grp->r_item[i].id], ui_grp->r_next, i);
+
+   for (i = ui_grp->s_cnt - 1; i >= 0; i--) {
+      if ((id = ui_grp->s_item[i].r_id) >= ui_grp->id_cnt)
+         _ui_index_list (&ui_grp->s_extra, ui_grp->s_next, i);
+      else if (id >= 0)
+         _ui_index_list (&ui_grp->s_head[id], ui_grp->s_next, i);
+   }
+}
+
 //------------------------------------------------------------------------------
 static r_item_t *_ui_find_r_item (ui_grp_t *ui_grp, int *sid, int fid)
 {
    int i;
    /*
       여러개의 같은 아이디가 있을 수 있으므로 아래와 같이 검색한다.
-      *sid = 시작 아이디
+      *sid = 0 이면 처음부터, 이후는 다음 item index + 1 (-1 = 검색 완료)
       fid  = 찾을 아이디
    */
-   for (i = *sid; i < ui_grp->r_cnt; i++) {
-      if (fid == ui_grp->r_item[i].id) {
-         *sid = i + 1;
-         return &ui_grp->r_item[i];
-      }
+   if ((fid < 0) || (fid >= ui_grp->id_cnt) || (*sid < 0))
+      return NULL;
+
+   if ((i = *sid ? (*sid - 1) : ui_grp->r_head[fid]) < 0) {
+      *sid = -1;
+      return NULL;
    }
-   return NULL;
+   *sid = (ui_grp->r_next[i] < 0) ? -1 : ui_grp->r_next[i] + 1;
+   return &ui_grp->r_item[i];
 }
 
 //------------------------------------------------------------------------------
@@ -104,16 +211,18 @@ static s_item_t *_ui_find_s_item (ui_grp_t *ui_grp, int *sid, int fid)
    int i;
    /*
       여러개의 같은 아이디가 있을 수 있으므로 아래와 같이 검색한다.
-      *sid = 시작 아이디
+      *sid = 0 이면 처음부터, 이후는 다음 item index + 1 (-1 = 검색 완료)
       fid  = 찾을 아이디
    */
-   for (i = *sid; i < ui_grp->s_cnt; i++) {
-      if (fid == ui_grp->s_item[i].r_id) {
-         *sid = i + 1;
-         return &ui_grp->s_item[i];
-      }
+   if ((fid < 0) || (fid >= ui_grp->id_cnt) || (*sid < 0))
+      return NULL;
+
+   if ((i = *sid ? (*sid - 1) : ui_grp->s_head[fid]) < 0) {
+      *sid = -1;
+      return NULL;
    }
-   return NULL;
+   *sid = (ui_grp->s_next[i] < 0) ? -1 : ui_grp->s_next[i] + 1;
+   return &ui_grp->s_item[i];
 }
 
 //------------------------------------------------------------------------------
@@ -135,35 +244,45 @@ static int _my_strlen(char *str)
 //------------------------------------------------------------------------------
 static int _ui_str_scale (int w, int h, int lw, int slen)
 {
-   int as, w_len, h_len;
+   int as;
 
    /* auto scaling */
-   /* 배율이 설정되어진 최대치 보다 큰 경우 종료한다. */
-   for (as = 1; as < ITEM_SCALE_MAX; as++) {
-      w_len = FONT_ASCII_WIDTH * as * slen + lw * 2;
-      h_len = FONT_HEIGHT      * as        + lw * 2;
-      /*
-         만약 배율이 1인 경우에도 화면에 표시되지 않는 경우 scale은 0값이 되고
-         문자열은 화면상의 표시가 되지 않는다.
-      */
-      if ((w_len > w) || (h_len > h)) {
-         if (as == 1)
-            err("String length too big. String can't display(scale = 0).\n");
-         return (as -1);
-      }
+   /* (FONT_ASCII_WIDTH * as * slen + lw * 2 <= w), (FONT_HEIGHT * as + lw * 2 <= h) 인 최대 배율 */
+   as = (h - lw * 2) / FONT_HEIGHT;
+   if (slen && (as > (w - lw * 2) / (FONT_ASCII_WIDTH * slen)))
+      as = (w - lw * 2) / (FONT_ASCII_WIDTH * slen);
+
+   /*
+      만약 배율이 1인 경우에도 화면에 표시되지 않는 경우 scale은 0값이 되고
+      문자열은 화면상의 표시가 되지 않는다.
+   */
+   if ((as < 1) || (w < lw * 2)) {
+      err("String length too big. String can't display(scale = 0).\n");
+      return 0;
+   }
+   /* 배율이 설정되어진 최대치 보다 큰 경우 */
+   return (as < ITEM_SCALE_MAX - 1) ? as : ITEM_SCALE_MAX;
+}
+
+//------------------------------------------------------------------------------
+// 자동 배율 (문자열 폭, rect가 이전과 같으면 계산하지 않음)
+//------------------------------------------------------------------------------
+static int _ui_auto_scale (r_item_t *r_item, s_item_t *s_item, int slen)
+{
+   if ((s_item->a_rect != r_item) || (s_item->a_len != slen)) {
+      s_item->a_rect  = r_item;
+      s_item->a_len   = slen;
+      s_item->a_scale = _ui_str_scale (r_item->w, r_item->h, r_item->lw, slen);
    }
-   return ITEM_SCALE_MAX;
+   return s_item->a_scale;
 }
 
 //------------------------------------------------------------------------------
 static void _ui_str_pos_xy (r_item_t *r_item, s_item_t *s_item)
 {
-   int slen = _my_strlen(s_item->str);
+   if (s_item->x < 0)
+      s_item->x = ((r_item->w - s_item->w_len * FONT_ASCII_WIDTH * s_item->scale) / 2);
 
-   if (s_item->x < 0) {
-      slen = slen * FONT_ASCII_WIDTH * s_item->scale;
-      s_item->x = ((r_item->w - slen) / 2);
-   }
    if (s_item->y < 0)
       s_item->y = ((r_item->h - FONT_HEIGHT * s_item->scale)) / 2;
 }
@@ -171,20 +290,20 @@ static void _ui_str_pos_xy (r_item_t *r_item, s_item_t *s_item)
 //------------------------------------------------------------------------------
 static void _ui_clr_str (fb_info_t *fb, r_item_t *r_item, s_item_t *s_item)
 {
-   int color = s_item->fc.uint;
-
-   /* 기존 String을 배경색으로 다시 그림(텍스트 지움) */
+   /* 기존 String 영역을 배경색으로 채움(텍스트 지움) */
    /* string x, y 좌표 연산 */
-   s_item->fc.uint = s_item->bc.uint;
    _ui_str_pos_xy(r_item, s_item);
-   _ui_update_s (fb, s_item, r_item->x, r_item->y);
-   s_item->fc.uint = color;
+   draw_fill_rect (fb, r_item->x + s_item->x, r_item->y + s_item->y,
+                  s_item->w_len * FONT_ASCII_WIDTH * s_item->scale,
+                  FONT_HEIGHT * s_item->scale, s_item->bc.uint);
    memset (s_item->str, 0x00, ITEM_STR_MAX);
+   s_item->w_len = 0;
 }
 
 //------------------------------------------------------------------------------
 static void _ui_update_r (fb_info_t *fb, r_item_t *r_item)
 {
+   r_item->dirty = false;
    draw_fill_rect (fb, r_item->x, r_item->y, r_item->w, r_item->h,
                      r_item->bc.uint);
    if (r_item->lw)
@@ -195,20 +314,100 @@ static void _ui_update_r (fb_info_t *fb, r_item_t *r_item)
 //------------------------------------------------------------------------------
 static void _ui_update_s (fb_info_t *fb, s_item_t *s_item, int x, int y)
 {
+   s_item->dirty = false;
    draw_text (fb, x + s_item->x, y + s_item->y, s_item->fc.uint, s_item->bc.uint,
                s_item->scale, s_item->str);
 }
 
+//------------------------------------------------------------------------------
+/* utf-8 문자 1개의 byte 수 (한글 3 bytes = 2 cell, ascii 1 byte = 1 cell) */
+static int _ui_glyph_len (const char *p)
+{
+   return ((*p & 0x80) && p[1] && p[2]) ? 3 : 1;
+}
+
+//------------------------------------------------------------------------------
+static void _ui_draw_run (fb_info_t *fb, s_item_t *s_item,
+                           const char *run, int len, int x, int y)
+{
+   char buf[ITEM_STR_MAX];
+
+   memcpy (buf, run, len);
+   buf[len] = 0x00;
+   draw_text (fb, x, y, s_item->fc.uint, s_item->bc.uint, s_item->scale, "%s", buf);
+}
+
+//------------------------------------------------------------------------------
+// 위치, 배율, 색, font가 그대로인 문자열 변경 (return : false = 전체를 다시 그려야 함)
+// 같은 cell에 같은 glyph가 있으면 그리지 않고, 줄어든 영역은 한번에 지운다.
+//------------------------------------------------------------------------------
+static bool _ui_update_s_diff (fb_info_t *fb, ui_grp_t *ui_grp, r_item_t *r_item,
+                                 s_item_t *s_item, char *str, int slen, int x, int y)
+{
+   s_item_t n_item;
+   char o_str[ITEM_STR_MAX], *n, *o, *run = NULL;
+   int cell = FONT_ASCII_WIDTH * s_item->scale, n_c = 0, o_c = 0, run_c = 0, len, o_len;
+
+   /*
+      같은 id의 rect가 여러개이면 rect 마다 같은 문자열을 그리므로
+      첫 rect에서 변경된 문자열을 기준으로 비교할 수 없다.
+   */
+   if (s_item->dirty || (ui_grp->r_next[r_item - ui_grp->r_item] >= 0) ||
+       (ui_grp->r_head[r_item->id] != r_item - ui_grp->r_item))
+      return false;
+
+   /* 새 문자열의 위치 (가운데 정렬이면 길이에 따라 바뀜) */
+   n_item       = *s_item;
+   n_item.x     = x;
+   n_item.y     = y;
+   n_item.w_len = slen;
+   _ui_str_pos_xy (r_item, &n_item);
+   if ((n_item.x != s_item->x) || (n_item.y != s_item->y))
+      return false;
+
+   memcpy (o_str, s_item->str, ITEM_STR_MAX);
+   o_len = s_item->w_len;
+   memset (s_item->str, 0x00, ITEM_STR_MAX);
+   strncpy (s_item->str, str, ITEM_STR_MAX - 1);
+   s_item->w_len = slen;
+   s_item->dirty = false;
+
+   x = r_item->x + s_item->x;
+   y = r_item->y + s_item->y;
+   for (n = s_item->str, o = o_str; *n; n += len) {
+      len = _ui_glyph_len (n);
+      /* 같은 cell 위치에서 시작하는 이전 glyph */
+      while (*o && (o_c < n_c)) {
+         o_c += (_ui_glyph_len (o) == 3) ? 2 : 1;
+         o   += _ui_glyph_len (o);
+      }
+      if (*o && (o_c == n_c) && (_ui_glyph_len (o) == len) && !memcmp (n, o, len)) {
+         if (run)
+            _ui_draw_run (fb, s_item, run, n - run, x + run_c * cell, y);
+         run = NULL;
+      }
+      else if (run == NULL) {
+         run   = n;
+         run_c = n_c;
+      }
+      n_c += (len == 3) ? 2 : 1;
+   }
+   if (run)
+      _ui_draw_run (fb, s_item, run, n - run, x + run_c * cell, y);
+
+   /* 이전 문자열이 더 길면 남은 영역을 지움 */
+   if (o_len > n_c)
+      draw_fill_rect (fb, x + n_c * cell, y, (o_len - n_c) * cell,
+                     FONT_HEIGHT * s_item->scale, s_item->bc.uint);
+   return true;
+}
+
 //------------------------------------------------------------------------------
 static void _ui_update_extra (fb_info_t *fb, ui_grp_t *ui_grp, int id)
 {
    // extra item update
    int i;
-   for (i = 0; i < ui_grp->r_cnt; i++)
-      if (id == ui_grp->r_item[i].id)
-         _ui_update_r (fb, &ui_grp->r_item[i]);
-
-   for (i = 0; i < ui_grp->s_cnt; i++)
+   for (i = ui_grp->s_extra; i >= 0; i = ui_grp->s_next[i])
       if (id == ui_grp->s_item[i].r_id)
          _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
 }
@@ -221,7 +420,7 @@ static void _ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
    r_item_t *r_item;
    s_item_t *s_item;
 
-   if (id < ITEM_COUNT_MAX) {
+   if (id < ui_grp->id_cnt) {
       while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
 
          _ui_update_r (fb, r_item);
@@ -237,8 +436,7 @@ static void _ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
             set_font(s_item->f_type);
 
             if (s_item->scale < 0)
-               s_item->scale = _ui_str_scale (r_item->w, r_item->h, r_item->lw,
-                                             _my_strlen(s_item->str));
+               s_item->scale = _ui_auto_scale (r_item, s_item, s_item->w_len);
             _ui_str_pos_xy(r_item, s_item);
             _ui_update_s (fb, s_item, r_item->x, r_item->y);
          }
@@ -262,13 +460,105 @@ static void _ui_parser_cmd_C (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
    set_font(ui_grp->f_type);
 }
 
+//------------------------------------------------------------------------------
+// G item 범위 검사 (id는 sid ~ sid + r_cnt * g_cnt - 1)
+//------------------------------------------------------------------------------
+static bool _ui_group_ok (int sid, int r_cnt, int g_cnt)
+{
+   if ((sid < 0) || (sid >= ITEM_ID_MAX) || (r_cnt <= 0) || (g_cnt <= 0))
+      return false;
+   if ((r_cnt > ITEM_ID_MAX) || (g_cnt > ITEM_ID_MAX))
+      return false;
+   return (sid + r_cnt * g_cnt) <= ITEM_ID_MAX;
+}
+
+//------------------------------------------------------------------------------
+// config 파일의 item 수, id 범위 계산 (item 저장공간 할당 전 1회 읽음)
+//------------------------------------------------------------------------------
+static bool _ui_count_items (FILE *pfd, int *r_max, int *s_max, int *id_cnt)
+{
+   char buf[256], *ptr;
+   int id, r_cnt, g_cnt;
+   bool is_cfg_file = false;
+
+   *r_max = *s_max = *id_cnt = 0;
+   memset (buf, 0x00, sizeof(buf));
+
+   while(fgets(buf, sizeof(buf), pfd) != NULL) {
+      if (!is_cfg_file) {
+         is_cfg_file = strncmp ("ODROID-UI-CONFIG", buf, strlen(buf)-1) == 0;
+         memset (buf, 0x00, sizeof(buf));
+         continue;
+      }
+      if ((buf[0] == 'R') || (buf[0] == 'G')) {
+         strtok (buf, ",");
+         id = ((ptr = strtok (NULL, ",")) != NULL) ? atoi(ptr) : -1;
+         r_cnt = g_cnt = 1;
+         if (buf[0] == 'G') {
+            r_cnt = ((ptr = strtok (NULL, ",")) != NULL) ? atoi(ptr) : 0;
+            strtok (NULL, ",");  strtok (NULL, ",");
+            g_cnt = ((ptr = strtok (NULL, ",")) != NULL) ? atoi(ptr) : 0;
+         }
+         /* 범위를 벗어난 item은 parser에서 건너뜀 */
+         if (_ui_group_ok (id, r_cnt, g_cnt)) {
+            *r_max += r_cnt * g_cnt;
+            if (*id_cnt < id + r_cnt * g_cnt)
+               *id_cnt = id + r_cnt * g_cnt;
+         }
+      }
+      else if (buf[0] == 'S')
+         (*s_max)++;
+      memset (buf, 0x00, sizeof(buf));
+   }
+   return is_cfg_file;
+}
+
+//------------------------------------------------------------------------------
+// ui_grp_t, item, index list를 한번에 할당 (free(ui_grp) 한번으로 해제)
+//------------------------------------------------------------------------------
+static ui_grp_t *_ui_alloc (int r_max, int s_max, int id_cnt)
+{
+   ui_grp_t *ui_grp;
+   char *arena;
+   size_t size = sizeof(ui_grp_t)
+               + sizeof(r_item_t) * r_max + sizeof(s_item_t) * s_max
+               + sizeof(int) * (id_cnt * 2 + r_max + s_max);
+
+   if ((arena = (char *)malloc(size)) == NULL) {
+      err("ui item alloc error! (r = %d, s = %d, id = %d)\n", r_max, s_max, id_cnt);
+      return NULL;
+   }
+   memset (arena, 0x00, size);
+
+   ui_grp = (ui_grp_t *)arena;    arena += sizeof(ui_grp_t);
+   ui_grp->r_max  = r_max;
+   ui_grp->s_max  = s_max;
+   ui_grp->id_cnt = id_cnt;
+
+   /* item 구조체는 int 정렬이므로 ui_grp_t 뒤에 순서대로 배치 */
+   ui_grp->r_item = (r_item_t *)arena;  arena += sizeof(r_item_t) * r_max;
+   ui_grp->s_item = (s_item_t *)arena;  arena += sizeof(s_item_t) * s_max;
+   ui_grp->r_head = (int *)arena;       arena += sizeof(int) * id_cnt;
+   ui_grp->s_head = (int *)arena;       arena += sizeof(int) * id_cnt;
+   ui_grp->r_next = (int *)arena;       arena += sizeof(int) * r_max;
+   ui_grp->s_next = (int *)arena;
+   return ui_grp;
+}
+
 //------------------------------------------------------------------------------
 static void _ui_parser_cmd_R (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
 {
-   int r_cnt = ui_grp->r_cnt;
+   int r_cnt = ui_grp->r_cnt, id;
    char *ptr = strtok (buf, ",");
 
-   ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].id   = atoi(ptr);
+   ptr = strtok (NULL, ",");     id = atoi(ptr);
+
+   /* _ui_count_items에서 같은 조건으로 계산하므로 정상 config는 넘지 않음 */
+   if ((id < 0) || (id >= ui_grp->id_cnt) || (r_cnt >= ui_grp->r_max)) {
+      err("R item skip! (id = %d, count = %d)\n", id, r_cnt);
+      return;
+   }
+   ui_grp->r_item[r_cnt].id   = id;
    ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].x    = atoi(ptr);
    ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].y    = atoi(ptr);
    ptr = strtok (NULL, ",");     ui_grp->r_item[r_cnt].w    = atoi(ptr);
@@ -302,6 +592,10 @@ static void _ui_parser_cmd_S (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
    int s_cnt = ui_grp->s_cnt;
    char *ptr = strtok (buf, ",");
 
+   if (s_cnt >= ui_grp->s_max) {
+      err("S item skip! (count = %d)\n", s_cnt);
+      return;
+   }
    ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].r_id    = atoi(ptr);
    ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].x       = atoi(ptr);
    ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].y       = atoi(ptr);
@@ -324,8 +618,9 @@ static void _ui_parser_cmd_S (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
       strncpy(ui_grp->s_item[s_cnt].str, ptr, slen);
    }
    ptr = strtok (NULL, ",");     ui_grp->s_item[s_cnt].f_type = atoi(ptr);
+   ui_grp->s_item[s_cnt].w_len  = _my_strlen (ui_grp->s_item[s_cnt].str);
 
-   if (ui_grp->s_item[s_cnt].r_id >= ITEM_COUNT_MAX) {
+   if (ui_grp->s_item[s_cnt].r_id >= ui_grp->id_cnt) {
       if (ui_grp->s_item[s_cnt].x < 0)          ui_grp->s_item[s_cnt].x = 0;
       if (ui_grp->s_item[s_cnt].y < 0)          ui_grp->s_item[s_cnt].y = 0;
       if (ui_grp->s_item[s_cnt].scale   < 0)    ui_grp->s_item[s_cnt].scale = 1;
@@ -357,6 +652,12 @@ static void _ui_parser_cmd_G (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
    ptr = strtok (NULL, ",");     lw    = atoi(ptr);
    ptr = strtok (NULL, ",");     lc    = strtol(ptr, NULL, 16);
 
+   if (!_ui_group_ok (sid, r_cnt, g_cnt) ||
+       (sid + r_cnt * g_cnt > ui_grp->id_cnt) ||
+       (pos + r_cnt * g_cnt > ui_grp->r_max)) {
+      err("G item skip! (id = %d, count = %d x %d)\n", sid, r_cnt, g_cnt);
+      return;
+   }
    for (i = 0; i < g_cnt; i++) {
       for (j = 0; j < r_cnt; j++) {
          pos = ui_grp->r_cnt + j + i * r_cnt;
@@ -374,7 +675,80 @@ static void _ui_parser_cmd_G (char *buf, fb_info_t *fb, ui_grp_t *ui_grp)
          ui_grp->r_item[pos].lc.uint = lc < 0 ? ui_grp->lc.uint : lc;
       }
    }
-   ui_grp->r_cnt = pos +1;
+   ui_grp->r_cnt += r_cnt * g_cnt;
+}
+
+//------------------------------------------------------------------------------
+// 현재 상태와 비교하여 화면이 바뀌는 경우만 true (같은 id의 item 모두 검사)
+//------------------------------------------------------------------------------
+static bool _ui_ritem_changed (ui_grp_t *ui_grp, int f_id, int bc, int lc)
+{
+   int n_rid = 0;
+   r_item_t *r_item;
+
+   while ((r_item = _ui_find_r_item(ui_grp, &n_rid, f_id)) != NULL) {
+      if (r_item->dirty)
+         return true;
+      if (((bc != -1) && (r_item->bc.uint != (unsigned)bc)) ||
+          ((lc != -1) && (r_item->lc.uint != (unsigned)lc)))
+         return true;
+   }
+   /* ui_set_ritem은 string 배경색도 변경 */
+   return _ui_sitem_changed (ui_grp, f_id, -1, bc, NULL);
+}
+
+//------------------------------------------------------------------------------
+static bool _ui_sitem_changed (ui_grp_t *ui_grp, int id, int fc, int bc, char *str)
+{
+   int n_sid = 0;
+   s_item_t *s_item;
+
+   while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
+      if (s_item->dirty)
+         return true;
+      if (((fc != -1) && (s_item->fc.uint != (unsigned)fc)) ||
+          ((bc != -1) && (s_item->bc.uint != (unsigned)bc)))
+         return true;
+      if ((str != NULL) && strncmp (s_item->str, str, ITEM_STR_MAX - 1))
+         return true;
+   }
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// ui_set_str과 같은 방법으로 문자열, 배율, font, 위치를 계산하여 비교
+//------------------------------------------------------------------------------
+static bool _ui_str_changed (ui_grp_t *ui_grp, int id, int x, int y,
+                              int scale, int font, char *str, int slen)
+{
+   int n_sid = 0, n_rid = 0, n_scale;
+   s_item_t *s_item, n_item;
+   r_item_t *r_item;
+
+   while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
+      n_sid = 0;
+      while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
+         if (s_item->dirty || strcmp (s_item->str, str))
+            return true;
+
+         n_scale = s_item->scale;
+         if (scale)
+            n_scale = (scale < 0) ? _ui_auto_scale (r_item, s_item, slen) : scale;
+         if (n_scale != s_item->scale)
+            return true;
+
+         if (font && (((font < 0) ? ui_grp->f_type : font) != s_item->f_type))
+            return true;
+
+         n_item   = *s_item;
+         n_item.x = (x != 0) ? x : s_item->x;
+         n_item.y = (y != 0) ? y : s_item->y;
+         _ui_str_pos_xy(r_item, &n_item);
+         if ((n_item.x != s_item->x) || (n_item.y != s_item->y))
+            return true;
+      }
+   }
+   return false;
 }
 
 //------------------------------------------------------------------------------
@@ -383,12 +757,24 @@ void ui_set_ritem (fb_info_t *fb, ui_grp_t *ui_grp,
 {
    int s_rid = 0;
    r_item_t *r_item;
+   bool found = false;
+
+   /* 색이 같으면 다시 그리지 않음 */
+   if ((f_id < ui_grp->id_cnt) && !_ui_ritem_changed (ui_grp, f_id, bc, lc))
+      return;
 
-   if (f_id < ITEM_COUNT_MAX) {
-      /* 같은 아이디를 찾아 모두 바꾼다. */
+   if (f_id < ui_grp->id_cnt) {
+      /* 같은 아이디를 찾아 모두 바꾼다. (다시 그릴 때까지 dirty) */
       while ((r_item = _ui_find_r_item(ui_grp, &s_rid, f_id)) != NULL) {
-         if (bc != -1)  r_item->bc.uint = bc;   
+         if (((bc != -1) && (r_item->bc.uint != (unsigned)bc)) ||
+             ((lc != -1) && (r_item->lc.uint != (unsigned)lc)))
+            r_item->dirty = true;
+         if (bc != -1)  r_item->bc.uint = bc;
          if (lc != -1)  r_item->lc.uint = lc;
+         found = true;
+      }
+      /* rect가 있는 경우 string 배경색과 같이 한번만 다시 그림 */
+      if (found) {
          ui_set_sitem (fb, ui_grp, f_id, -1, bc, NULL);
          ui_update (fb, ui_grp, f_id);
       }
@@ -399,15 +785,29 @@ void ui_set_ritem (fb_info_t *fb, ui_grp_t *ui_grp,
 void ui_set_sitem (fb_info_t *fb, ui_grp_t *ui_grp,
                      int id, int fc, int bc, char *str)
 {
-   int n_sid = 0, n_rid = 0;
+   int n_sid = 0, n_rid = 0, slen;
    s_item_t *s_item;
    r_item_t *r_item;
 
-   if (id < ITEM_COUNT_MAX) {
+   /* 문자열, 색이 같으면 다시 그리지 않음 */
+   if ((id < ui_grp->id_cnt) && !_ui_sitem_changed (ui_grp, id, fc, bc, str))
+      return;
+
+   if (id < ui_grp->id_cnt) {
+      /* 문자열 폭은 한번만 계산 */
+      slen = (str != NULL) ? _my_strlen (str) : 0;
       while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
          n_sid = 0;
          while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
 
+            /* 색이 그대로이면 바뀐 glyph만 다시 그림 */
+            if ((str != NULL) &&
+                ((fc == -1) || (s_item->fc.uint == (unsigned)fc)) &&
+                ((bc == -1) || (s_item->bc.uint == (unsigned)bc)) &&
+                _ui_update_s_diff (fb, ui_grp, r_item, s_item, str, slen,
+                                    s_item->x, s_item->y))
+               continue;
+
             /* font color 변경 */
             if (fc != -1)
                s_item->fc.uint = fc;
@@ -430,6 +830,7 @@ void ui_set_sitem (fb_info_t *fb, ui_grp_t *ui_grp,
 
                /* 새로운 string 복사 */
                strncpy(s_item->str, buf, strlen(buf));
+               s_item->w_len = slen;
             }
 
             _ui_str_pos_xy(r_item, s_item);
@@ -443,27 +844,37 @@ void ui_set_sitem (fb_info_t *fb, ui_grp_t *ui_grp,
 void ui_set_str (fb_info_t *fb, ui_grp_t *ui_grp,
                   int id, int x, int y, int scale, int font, char *fmt, ...)
 {
-   int n_sid = 0, n_rid = 0;
+   int n_sid = 0, n_rid = 0, slen;
    s_item_t *s_item;
    r_item_t *r_item;
+   va_list va;
+   char buf[ITEM_STR_MAX];
+
+   /* 받아온 가변인자를 string 형태로 변환 하여 buf에 저장 */
+   memset(buf, 0x00, sizeof(buf));
+   va_start(va, fmt);   vsnprintf(buf, sizeof(buf), fmt, va); va_end(va);
+   slen = _my_strlen (buf);
 
-   if (id < ITEM_COUNT_MAX) {
+   if (id < ui_grp->id_cnt) {
+      /*
+         문자열, 배율, 위치가 같으면 다시 그리지 않음
+         (이후 ui_set_sitem은 현재 font로 그리므로 font 선택은 유지)
+      */
+      if (!_ui_str_changed (ui_grp, id, x, y, scale, font, buf, slen)) {
+         if (font)
+            set_font((font < 0) ? ui_grp->f_type : font);
+         return;
+      }
       while ((r_item = _ui_find_r_item(ui_grp, &n_rid, id)) != NULL) {
          n_sid = 0;
          while ((s_item = _ui_find_s_item(ui_grp, &n_sid, id)) != NULL) {
-            va_list va;
-            char buf[ITEM_STR_MAX];
-            int n_scale = s_item->scale;
-
-            /* 받아온 가변인자를 string 형태로 변환 하여 buf에 저장 */
-            memset(buf, 0x00, sizeof(buf));
-            va_start(va, fmt);   vsprintf(buf, fmt, va); va_end(va);
+            int n_scale = s_item->scale, f_type;
+            bool f_changed = false;
 
             if (scale) {
                /* scale = -1 이면 최대 스케일을 구하여 표시한다 */
                if (scale < 0)
-                  n_scale = _ui_str_scale (r_item->w, r_item->h,
-                                             r_item->lw, _my_strlen(buf));
+                  n_scale = _ui_auto_scale (r_item, s_item, slen);
                else
                   n_scale = scale;
 
@@ -472,10 +883,18 @@ void ui_set_str (fb_info_t *fb, ui_grp_t *ui_grp,
             }
 
             if (font) {
-               s_item->f_type = (font < 0) ? ui_grp->f_type : font;
+               f_type = (font < 0) ? ui_grp->f_type : font;
+               f_changed = (f_type != s_item->f_type);
+               s_item->f_type = f_type;
                set_font(s_item->f_type);
             }
 
+            /* 배율, font가 그대로이면 바뀐 glyph만 다시 그림 */
+            if (!f_changed && (n_scale == s_item->scale) &&
+                _ui_update_s_diff (fb, ui_grp, r_item, s_item, buf, slen,
+                                    (x != 0) ? x : s_item->x, (y != 0) ? y : s_item->y))
+               continue;
+
             /*
                기존 문자열 보다 새로운 문자열이 더 작은 경우
                기존 문자열을 배경색으로 덮어 씌운다.
@@ -485,10 +904,11 @@ void ui_set_str (fb_info_t *fb, ui_grp_t *ui_grp,
                s_item->scale = n_scale;
             }
             s_item->x = (x != 0) ? x : s_item->x;
-            s_item->y = (y != 0) ? x : s_item->y;
+            s_item->y = (y != 0) ? y : s_item->y;
 
             /* 새로운 string 복사 */
             strncpy(s_item->str, buf, strlen(buf));
+            s_item->w_len = slen;
 
             _ui_str_pos_xy(r_item, s_item);
             _ui_update_s (fb, s_item, r_item->x, r_item->y);
@@ -496,20 +916,23 @@ void ui_set_str (fb_info_t *fb, ui_grp_t *ui_grp,
       }
    } else {
       int i;
-      for (i = 0; i < ui_grp->s_cnt; i++) {
-         if (ui_grp->s_item[i].r_id == id) {
-            int color = ui_grp->s_item[i].fc.uint;
-
-            /* 기존 문자열을 벼경색으로 다시 그려서 지움 */
-            ui_grp->s_item[i].fc.uint = ui_grp->s_item[i].bc.uint;
-            _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
-            ui_grp->s_item[i].fc.uint = color;
-            ui_grp->s_item[i].scale = (scale > 0) ? scale : 1;
-            ui_grp->s_item[i].f_type = font;
-            ui_grp->s_item[i].x = x;
-            ui_grp->s_item[i].y = y;
-            _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
-         }
+      for (i = ui_grp->s_extra; i >= 0; i = ui_grp->s_next[i]) {
+         s_item = &ui_grp->s_item[i];
+         /* 위치, 배율, font가 같으면 다시 그리지 않음 */
+         if ((s_item->r_id != id) || (!s_item->dirty &&
+             (s_item->scale == ((scale > 0) ? scale : 1)) &&
+             (s_item->f_type == font) && (s_item->x == x) && (s_item->y == y)))
+            continue;
+
+         /* 기존 문자열 영역을 배경색으로 채워서 지움 */
+         draw_fill_rect (fb, s_item->x, s_item->y,
+                        s_item->w_len * FONT_ASCII_WIDTH * s_item->scale,
+                        FONT_HEIGHT * s_item->scale, s_item->bc.uint);
+         s_item->scale = (scale > 0) ? scale : 1;
+         s_item->f_type = font;
+         s_item->x = x;
+         s_item->y = y;
+         _ui_update_s (fb, s_item, 0, 0);
       }
    }
 }
@@ -535,27 +958,327 @@ void ui_update (fb_info_t *fb, ui_grp_t *ui_grp, int id)
 
    /* ui_grp에 등록되어있는 모든 item에 대하여 화면 업데이트 함 */
    if (id < 0) {
-      /* 사각형 item에 대한 화면 업데이트 */
-      for (i = 0; i < ui_grp->r_cnt; i++)
-         _ui_update (fb, ui_grp, i);
+      /* 사각형 item에 대한 화면 업데이트 (item이 있는 id만) */
+      for (i = 0; i < ui_grp->id_cnt; i++)
+         if (ui_grp->r_head[i] >= 0)
+            _ui_update (fb, ui_grp, i);
 
       /* 문자열 item에 대한 화면 업데이트 */
-      for (i = 0; i < ui_grp->s_cnt; i++) {
-         if (ui_grp->s_item[i].r_id >= ITEM_COUNT_MAX)
-            _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
-      }
+      for (i = ui_grp->s_extra; i >= 0; i = ui_grp->s_next[i])
+         _ui_update_s (fb, &ui_grp->s_item[i], 0, 0);
    }
    else  /* id값으로 설정된 1 개의 item에 대한 화면 업데이트 */
       _ui_update (fb, ui_grp, id);
 
 }
 
+//------------------------------------------------------------------------------
+static __u64 _ui_time_us (void)
+{
+   struct timespec ts;
+
+   clock_gettime (CLOCK_MONOTONIC, &ts);
+   return (__u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+// 대기 queue에 id의 요청 추가 (mutex lock 상태에서 호출, NULL = queue full)
+//------------------------------------------------------------------------------
+static ui_cmd_t *_ui_post_new (ui_render_t *r, int id)
+{
+   ui_cmd_t *cmd;
+
+   if (r->cmd_cnt == r->cmd_max)
+      return NULL;
+
+   cmd = &r->cmd[r->cmd_cnt++];
+   memset (cmd, 0x00, sizeof(ui_cmd_t));
+   cmd->id   = id;
+   cmd->r_bc = cmd->r_lc = cmd->s_fc = cmd->s_bc = -1;
+   return cmd;
+}
+
+//------------------------------------------------------------------------------
+// id에 대기중인 요청(마지막 요청)을 찾거나 새로 등록 (mutex lock 상태로 return)
+//------------------------------------------------------------------------------
+static ui_cmd_t *_ui_post_get (ui_render_t *r, int id)
+{
+   ui_cmd_t *cmd;
+   int i;
+
+   if (r == NULL) {
+      err("ui render thread not started! (id = %d)\n", id);
+      return NULL;
+   }
+   pthread_mutex_lock (&r->mutex);
+   for (i = r->cmd_cnt - 1; i >= 0; i--)
+      if (r->cmd[i].id == id)
+         return &r->cmd[i];
+
+   if ((cmd = _ui_post_new (r, id)) == NULL) {
+      pthread_mutex_unlock (&r->mutex);
+      err("ui render queue full! (id = %d)\n", id);
+   }
+   return cmd;
+}
+
+//------------------------------------------------------------------------------
+// ui_post_str의 0(유지) 인자를 대기중인 요청에서 이어받아도 결과가 같은지 확인
+// (-1 = 그 당시의 문자열 길이로 위치/배율을 계산하므로 이어받을 수 없음)
+//------------------------------------------------------------------------------
+static bool _ui_post_str_merge (ui_cmd_t *cmd, int x, int y, int scale)
+{
+   if (!(cmd->flags & UI_CMD_STR))
+      return true;
+
+   return (x || (cmd->x >= 0)) && (y || (cmd->y >= 0)) && (scale || (cmd->scale >= 0));
+}
+
+//------------------------------------------------------------------------------
+static void _ui_post_done (ui_render_t *r)
+{
+   /* 첫 요청인 경우만 깨움 (이후 요청은 같은 frame에 합쳐짐) */
+   bool wakeup = (r->cmd_cnt == 1);
+
+   pthread_mutex_unlock (&r->mutex);
+   if (wakeup)
+      eventfd_write (r->e_fd, 1);
+}
+
+//------------------------------------------------------------------------------
+void ui_post_ritem (ui_grp_t *ui_grp, int f_id, int bc, int lc)
+{
+   ui_cmd_t *cmd;
+
+   if ((cmd = _ui_post_get (ui_grp->render, f_id)) == NULL)
+      return;
+
+   cmd->flags |= UI_CMD_RITEM;
+   if (bc != -1) {
+      /* ui_set_ritem은 string 배경색도 같이 변경함 */
+      cmd->r_bc = bc;
+      cmd->s_bc = -1;
+   }
+   if (lc != -1)
+      cmd->r_lc = lc;
+   _ui_post_done (ui_grp->render);
+}
+
+//------------------------------------------------------------------------------
+void ui_post_sitem (ui_grp_t *ui_grp, int id, int fc, int bc, char *str)
+{
+   ui_cmd_t *cmd;
+
+   if ((cmd = _ui_post_get (ui_grp->render, id)) == NULL)
+      return;
+
+   cmd->flags |= UI_CMD_SCOLOR;
+   if (fc != -1)  cmd->s_fc = fc;
+   if (bc != -1)  cmd->s_bc = bc;
+   if (str != NULL) {
+      snprintf (cmd->s_str, sizeof(cmd->s_str), "%s", str);
+      cmd->flags |= UI_CMD_SITEM_STR;
+   }
+   _ui_post_done (ui_grp->render);
+}
+
+//------------------------------------------------------------------------------
+void ui_post_str (ui_grp_t *ui_grp,
+                  int id, int x, int y, int scale, int font, char *fmt, ...)
+{
+   ui_cmd_t *cmd;
+   va_list va;
+   char buf[ITEM_STR_MAX];
+
+   /* lock 밖에서 문자열 변환 */
+   va_start(va, fmt);   vsnprintf(buf, sizeof(buf), fmt, va);  va_end(va);
+
+   if ((cmd = _ui_post_get (ui_grp->render, id)) == NULL)
+      return;
+
+   /* 합칠 수 없으면 같은 id로 따로 등록하여 순서대로 그림 (id 수 만큼만 허용) */
+   if (!_ui_post_str_merge (cmd, x, y, scale) &&
+       (ui_grp->render->cmd_cnt < ui_grp->render->id_max))
+      cmd = _ui_post_new (ui_grp->render, id);
+
+   /* 0 = 현재 값 유지 (ui_set_str과 같음) */
+   if (x)      cmd->x     = x;
+   if (y)      cmd->y     = y;
+   if (scale)  cmd->scale = scale;
+   if (font)   cmd->font  = font;
+   memcpy (cmd->str, buf, sizeof(buf));
+   cmd->flags = (cmd->flags & ~UI_CMD_SITEM_STR) | UI_CMD_STR;
+   _ui_post_done (ui_grp->render);
+}
+
+//------------------------------------------------------------------------------
+void ui_post_printf (ui_grp_t *ui_grp, int id, char *fmt, ...)
+{
+   va_list va;
+   char buf[ITEM_STR_MAX];
+
+   va_start(va, fmt);   vsnprintf(buf, sizeof(buf), fmt, va);  va_end(va);
+
+   ui_post_str (ui_grp, id, -1, -1, -1, -1, "%s", buf);
+}
+
+//------------------------------------------------------------------------------
+void ui_post_update (ui_grp_t *ui_grp, int id)
+{
+   ui_cmd_t *cmd;
+
+   if ((cmd = _ui_post_get (ui_grp->render, id)) == NULL)
+      return;
+
+   cmd->flags |= UI_CMD_UPDATE;
+   _ui_post_done (ui_grp->render);
+}
+
+//------------------------------------------------------------------------------
+// 합쳐진 요청을 ui_set_* 호출 순서로 변환 (최종 화면은 개별 호출과 같음)
+//------------------------------------------------------------------------------
+static void _ui_render_cmd (fb_info_t *fb, ui_grp_t *ui_grp, ui_cmd_t *cmd)
+{
+   int n_sid = 0;
+   s_item_t *s_item;
+
+   /* ritem은 item 전체를 다시 그림 */
+   if (cmd->flags & UI_CMD_RITEM)
+      ui_set_ritem (fb, ui_grp, cmd->id, cmd->r_bc, cmd->r_lc);
+   else if (cmd->flags & UI_CMD_UPDATE)
+      ui_update (fb, ui_grp, cmd->id);
+
+   /* ui_set_str은 문자열 길이로 배율, 위치를 다시 계산하므로 sitem 문자열보다 먼저 */
+   if (cmd->flags & UI_CMD_STR) {
+      /* 색 변경은 문자열을 다시 그릴 때 같이 반영 */
+      if ((cmd->flags & UI_CMD_SCOLOR) && (cmd->id < ui_grp->id_cnt)) {
+         while ((s_item = _ui_find_s_item(ui_grp, &n_sid, cmd->id)) != NULL) {
+            if (((cmd->s_fc != -1) && (s_item->fc.uint != (unsigned)cmd->s_fc)) ||
+                ((cmd->s_bc != -1) && (s_item->bc.uint != (unsigned)cmd->s_bc)))
+               s_item->dirty = true;
+            if (cmd->s_fc != -1)  s_item->fc.uint = cmd->s_fc;
+            if (cmd->s_bc != -1)  s_item->bc.uint = cmd->s_bc;
+         }
+      }
+      ui_set_str (fb, ui_grp, cmd->id, cmd->x, cmd->y, cmd->scale, cmd->font,
+                  "%s", cmd->str);
+   }
+   if (cmd->flags & UI_CMD_SITEM_STR)
+      ui_set_sitem (fb, ui_grp, cmd->id, cmd->s_fc, cmd->s_bc, cmd->s_str);
+   else if ((cmd->flags & UI_CMD_SCOLOR) && !(cmd->flags & UI_CMD_STR))
+      ui_set_sitem (fb, ui_grp, cmd->id, cmd->s_fc, cmd->s_bc, NULL);
+}
+
+//------------------------------------------------------------------------------
+static void *_ui_render_thread (void *arg)
+{
+   ui_render_t *r = (ui_render_t *)arg;
+   ui_cmd_t *cmd;
+   int cnt, i;
+   bool stop = false;
+   eventfd_t ev;
+   __u64 now, next = 0;
+
+   while (!stop) {
+      if (eventfd_read (r->e_fd, &ev) < 0) {
+         if (errno == EINTR)
+            continue;
+         err("ui render eventfd error! (%s)\n", strerror(errno));
+         break;
+      }
+      /* frame 간격 제한 : 기다리는 동안 들어온 요청은 하나로 합쳐진다. */
+      if ((now = _ui_time_us ()) < next)
+         usleep (next - now);
+      next = _ui_time_us () + r->frame_us;
+
+      pthread_mutex_lock (&r->mutex);
+      cnt  = r->cmd_cnt;
+      stop = r->stop;
+      cmd  = r->cmd;
+      r->cmd  = r->draw;
+      r->draw = cmd;
+      r->cmd_cnt = 0;
+      pthread_mutex_unlock (&r->mutex);
+
+      for (i = 0; i < cnt; i++)
+         _ui_render_cmd (r->fb, r->ui_grp, &cmd[i]);
+      fb_flush (r->fb);
+      r->frames++;
+   }
+   return NULL;
+}
+
+//------------------------------------------------------------------------------
+bool ui_render_start (fb_info_t *fb, ui_grp_t *ui_grp, int fps)
+{
+   ui_render_t *r;
+
+   if ((r = (ui_render_t *)malloc(sizeof(ui_render_t))) == NULL)
+      return false;
+
+   memset (r, 0x00, sizeof(ui_render_t));
+   r->fb       = fb;
+   r->ui_grp   = ui_grp;
+   r->frame_us = 1000000 / ((fps > 0) ? fps : UI_RENDER_FPS);
+   r->id_max   = ui_grp->id_cnt + ui_grp->s_cnt + 1;
+   r->cmd_max  = r->id_max * 2;
+
+   /* ui_init에서 그린 화면 */
+   fb_flush (fb);
+
+   pthread_mutex_init (&r->mutex, NULL);
+   r->cmd  = (ui_cmd_t *)malloc(sizeof(ui_cmd_t) * r->cmd_max);
+   r->draw = (ui_cmd_t *)malloc(sizeof(ui_cmd_t) * r->cmd_max);
+   if ((r->cmd == NULL) || (r->draw == NULL)) {
+      err("ui render queue alloc error! (%d)\n", r->cmd_max);
+      goto out;
+   }
+   if ((r->e_fd = eventfd (0, EFD_CLOEXEC)) < 0) {
+      err("ui render eventfd create error!\n");
+      goto out;
+   }
+   if (pthread_create (&r->thread, NULL, _ui_render_thread, r)) {
+      err("ui render thread create error!\n");
+      close (r->e_fd);
+      goto out;
+   }
+   ui_grp->render = r;
+   return true;
+out:
+   pthread_mutex_destroy (&r->mutex);
+   free (r->cmd);
+   free (r->draw);
+   free (r);
+   return false;
+}
+
+//------------------------------------------------------------------------------
+// 대기중인 요청을 모두 그린 후 종료
+//------------------------------------------------------------------------------
+static void _ui_render_stop (ui_render_t *r)
+{
+   pthread_mutex_lock (&r->mutex);
+   r->stop = true;
+   pthread_mutex_unlock (&r->mutex);
+   eventfd_write (r->e_fd, 1);
+
+   pthread_join (r->thread, NULL);
+   close (r->e_fd);
+   pthread_mutex_destroy (&r->mutex);
+   free (r->cmd);
+   free (r->draw);
+   free (r);
+}
+
 //------------------------------------------------------------------------------
 void ui_close (ui_grp_t *ui_grp)
 {
    /* 할당받은 메모리가 있다면 시스템으로 반환한다. */
-   if (ui_grp)
+   if (ui_grp) {
+      if (ui_grp->render)
+         _ui_render_stop (ui_grp->render);
       free (ui_grp);
+   }
 }
 
 //------------------------------------------------------------------------------
@@ -563,15 +1286,23 @@ ui_grp_t *ui_init (fb_info_t *fb, const char *cfg_filename)
 {
    ui_grp_t	*ui_grp;
    FILE *pfd;
-   char buf[256], r_cnt = 0, s_cnt = 0, *ptr, is_cfg_file = 0;
+   char buf[256], is_cfg_file = 0;
+   int r_max, s_max, id_cnt;
 
    if ((pfd = fopen(cfg_filename, "r")) == NULL)
       return   NULL;
 
-	if ((ui_grp = (ui_grp_t *)malloc(sizeof(ui_grp_t))) == NULL)
+   /* item 수를 먼저 계산하여 필요한 만큼만 할당 */
+   if (!_ui_count_items (pfd, &r_max, &s_max, &id_cnt)) {
+      err("UI Config File not found! (filename = %s)\n", cfg_filename);
+      fclose (pfd);
+      return NULL;
+   }
+	if ((ui_grp = _ui_alloc (r_max, s_max, id_cnt)) == NULL) {
+      fclose (pfd);
       return   NULL;
-
-   memset (ui_grp, 0x00, sizeof(ui_grp_t));
+   }
+   rewind (pfd);
    memset (buf,    0x00, sizeof(buf));
 
    while(fgets(buf, sizeof(buf), pfd) != NULL) {
@@ -596,9 +1327,12 @@ ui_grp_t *ui_init (fb_info_t *fb, const char *cfg_filename)
    if (!is_cfg_file) {
       err("UI Config File not found! (filename = %s)\n", cfg_filename);
       free (ui_grp);
+      fclose (pfd);
       return NULL;
    }
 
+   _ui_build_index (ui_grp);
+
    /* all item update */
    if (ui_grp->r_cnt)
       ui_update (fb, ui_grp, -1);
@@ -18,27 +18,59 @@
 #include "lib_fb.h"
 
 //------------------------------------------------------------------------------
-#define	ITEM_COUNT_MAX	64
+/* r_item id 범위 (0 ~ ITEM_ID_MAX-1), item 수는 config 파일에서 계산 */
+#define	ITEM_ID_MAX		4096
 #define	ITEM_STR_MAX	64
 #define	ITEM_SCALE_MAX	100
 
+/* render thread 최대 frame rate (변경 요청은 frame 단위로 합쳐서 그림) */
+#define	UI_RENDER_FPS	30
+
 //------------------------------------------------------------------------------
 typedef struct rect_item__t {
 	int				id, x, y, w, h, lw;
 	fb_color_u		bc, lc;
+	/* 화면에 그려진 내용과 다름 (다음 ui_set_*에서 변경이 없어도 다시 그림) */
+	bool			dirty;
 }	r_item_t;
 
 typedef struct string_item__t {
 	int				r_id, x, y, scale, f_type;
 	fb_color_u		fc, bc;
 	char            str[ITEM_STR_MAX];
+	bool			dirty;
+	/*
+		layout cache
+		w_len   : str의 폭 (ascii 문자 단위, 한글 = 2), str을 바꿀 때 같이 갱신
+		a_scale : a_rect 안에 a_len 폭의 문자열을 표시하는 최대 배율 (scale = -1)
+	*/
+	int				w_len, a_len, a_scale;
+	r_item_t		*a_rect;
 }	s_item_t;
 
+struct ui_render__t;
+
 typedef struct ui_group__t {
 	int             r_cnt, s_cnt, f_type;
     fb_color_u      fc, bc, lc;
-	r_item_t		r_item[ITEM_COUNT_MAX];
-	s_item_t		s_item[ITEM_COUNT_MAX];
+	/*
+		config 파일의 item 수로 ui_grp_t와 같이 한번에 할당 (ui_close에서 해제)
+		r_max, s_max = 할당된 item 수, id_cnt = 가장 큰 r_item id + 1
+	*/
+	int				r_max, s_max, id_cnt;
+	r_item_t		*r_item;
+	s_item_t		*s_item;
+	/*
+		id별 item index list (ui_init에서 생성, -1 = 끝)
+		head[id] -> next[index] -> ... 순서는 config 파일의 순서와 같다.
+		head[id_cnt], r_next[r_max], s_next[s_max]
+	*/
+	int				*r_head, *r_next;
+	int				*s_head, *s_next;
+	/* r_id >= id_cnt 인 s_item list (화면 좌표로 그림, next로 연결) */
+	int				s_extra;
+	/* ui_render_start 이후 화면은 render thread에서만 그린다. */
+	struct ui_render__t	*render;
 }	ui_grp_t;
 
 //------------------------------------------------------------------------------
@@ -51,6 +83,16 @@ extern	void        ui_set_str	(fb_info_t *fb, ui_grp_t *ui_grp,
 extern	void        ui_set_printf	(fb_info_t *fb, ui_grp_t *ui_grp,
                                  		int id, char *fmt, ...);
 extern	void        ui_update   (fb_info_t *fb, ui_grp_t *ui_grp, int id);
+
+/* render thread로 전달 (호출한 thread는 화면을 그리지 않음) */
+extern	void        ui_post_ritem	(ui_grp_t *ui_grp, int f_id, int bc, int lc);
+extern	void        ui_post_sitem	(ui_grp_t *ui_grp, int id, int fc, int bc, char *str);
+extern	void        ui_post_str		(ui_grp_t *ui_grp,
+						int id, int x, int y, int scale, int font, char *fmt, ...);
+extern	void        ui_post_printf	(ui_grp_t *ui_grp, int id, char *fmt, ...);
+extern	void        ui_post_update	(ui_grp_t *ui_grp, int id);
+extern	bool        ui_render_start	(fb_info_t *fb, ui_grp_t *ui_grp, int fps);
+
 extern	void        ui_close    (ui_grp_t *ui_grp);
 extern	ui_grp_t	*ui_init    (fb_info_t *fb, const char *cfg_filename);
 
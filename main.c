@@ -140,9 +140,13 @@ void _parse_model_name (jig_server_t *pserver)
 
 	_strtok_strcpy(pserver->model);
 
-	pserver->dual_ch = false;
+	/* jig channel count (0 이면 UART 설정 개수로 결정) */
+	pserver->ch_cnt = 0;
 	if ((ptr = strtok (NULL, ",")) != NULL)
-		pserver->dual_ch = (atoi(ptr) > 1) ? true : false;
+		pserver->ch_cnt = atoi(ptr);
+
+	if ((pserver->ch_cnt < 0) || (pserver->ch_cnt > CH_COUNT_MAX))
+		pserver->ch_cnt = CH_COUNT_MAX;
 }
 
 //------------------------------------------------------------------------------
@@ -152,10 +156,42 @@ void _parse_fb_config (jig_server_t *pserver)
 }
 
 //------------------------------------------------------------------------------
+//UART, /dev/ttyUSB0, /dev/ttyUSB1, ...
 void _parse_uart_config (jig_server_t *pserver)
 {
-	_strtok_strcpy(pserver->uart_dev[0]);
-	_strtok_strcpy(pserver->uart_dev[1]);
+	char *ptr;
+	int ch;
+
+	/* 설정된 device node 개수 만큼 channel 생성 (최대 CH_COUNT_MAX) */
+	for (ch = 0; ch < CH_COUNT_MAX; ch++) {
+		if ((ptr = strtok (NULL, ",")) == NULL)
+			break;
+		ptr = _str_remove_space(ptr);
+		if ((*ptr == '\n') || (*ptr == '\r') || (*ptr == 0x00))
+			break;
+		strncpy(pserver->ch[ch].uart_dev, ptr,
+				sizeof(pserver->ch[ch].uart_dev) -1);
+	}
+}
+
+//------------------------------------------------------------------------------
+//BAUD, 3000000,
+void _parse_baud_config (jig_server_t *pserver)
+{
+	char *ptr;
+
+	if ((ptr = strtok (NULL, ",")) != NULL)
+		pserver->baud_max = strtoul(ptr, NULL, 10);
+}
+
+//------------------------------------------------------------------------------
+//WINDOW, 4,
+void _parse_window_config (jig_server_t *pserver)
+{
+	char *ptr;
+
+	if ((ptr = strtok (NULL, ",")) != NULL)
+		pserver->cmd_window = atoi(ptr);
 }
 
 //------------------------------------------------------------------------------
@@ -223,9 +259,11 @@ bool parse_cfg_file (char *cfg_filename, jig_server_t *pserver)
 		if (!strncmp(ptr, "MODEL", strlen("MODEL")))	_parse_model_name (pserver);
 		if (!strncmp(ptr,    "FB", strlen("FB")))		_parse_fb_config  (pserver);
 		if (!strncmp(ptr,  "UART", strlen("UART")))		_parse_uart_config(pserver);
+		if (!strncmp(ptr,  "BAUD", strlen("BAUD")))		_parse_baud_config(pserver);
 		if (!strncmp(ptr,   "ADC", strlen("ADC")))		_parse_adc_config (pserver);
 		if (!strncmp(ptr,   "NLP", strlen("NLP")))		_parse_nlp_config (pserver);
 		if (!strncmp(ptr,   "CMD", strlen("CMD")))		_parse_cmd_config (pserver);
+		if (!strncmp(ptr,"WINDOW", strlen("WINDOW")))	_parse_window_config (pserver);
 		memset (buf, 0x00, sizeof(buf));
 	}
 
@@ -236,6 +274,26 @@ bool parse_cfg_file (char *cfg_filename, jig_server_t *pserver)
 		err("This file is not JIG Config File! (filename = %s)\n", cfg_filename);
 		return false;
 	}
+
+	/* MODEL의 channel count와 UART device 설정 개수 중 작은 값을 사용 */
+	{
+		int ch, ch_cnt = pserver->ch_cnt ? pserver->ch_cnt : CH_COUNT_MAX;
+
+		for (ch = 0; ch < ch_cnt; ch++) {
+			if (!pserver->ch[ch].uart_dev[0])
+				break;
+			pserver->ch[ch].id = ch;
+		}
+		pserver->ch_cnt = ch;
+	}
+	if (!pserver->ch_cnt) {
+		err("UART device not found! (filename = %s)\n", cfg_filename);
+		return false;
+	}
+	if (pserver->baud_max < BAUD_BASE)
+		pserver->baud_max = BAUD_BASE;
+	if ((pserver->cmd_window < 1) || (pserver->cmd_window > CMD_WINDOW_MAX))
+		pserver->cmd_window = (pserver->cmd_window < 1) ? 1 : CMD_WINDOW_MAX;
 	return true;
 }
 
@@ -243,6 +301,7 @@ bool parse_cfg_file (char *cfg_filename, jig_server_t *pserver)
 int main(int argc, char **argv)
 {
 	jig_server_t	*pserver;
+	int				ch;
 
     parse_opts(argc, argv);
 
@@ -267,10 +326,13 @@ int main(int argc, char **argv)
 		goto err_out;
 	}
 
-	info("UART Device : %s, baud = 115200bps(%d)\n", pserver->uart_dev[0], B115200);
-	if ((pserver->puart[0] = uart_init (pserver->uart_dev[0], B115200)) == NULL) {
-		err ("create ui fail!\n");
-		goto err_out;
+	for (ch = 0; ch < pserver->ch_cnt; ch++) {
+		info("UART Device(ch %d) : %s, baud = 115200bps(%d), max = %dbps\n",
+				ch, pserver->ch[ch].uart_dev, B115200, pserver->baud_max);
+		if ((pserver->ch[ch].puart = uart_init (pserver->ch[ch].uart_dev, B115200)) == NULL) {
+			err ("create uart fail!\n");
+			goto err_out;
+		}
 	}
 
 	info("UI Config file : %s\n", OPT_UI_CFG_FILE);
@@ -278,12 +340,21 @@ int main(int argc, char **argv)
 		err ("create ui fail!\n");
 		goto err_out;
 	}
+	if (!ui_render_start (pserver->pfb, pserver->pui, UI_RENDER_FPS)) {
+		err ("create ui render thread fail!\n");
+		goto err_out;
+	}
 
 	// main control function (server.c)
 	server_main (pserver);
 
 err_out:
-	uart_close (pserver->puart[0]);
+	/* channel thread가 uart(ptc_grp_t)를 사용하므로 먼저 종료 */
+	for (ch = 0; ch < pserver->ch_cnt; ch++) {
+		ch_close (&pserver->ch[ch]);
+		if (pserver->ch[ch].puart)
+			uart_close (pserver->ch[ch].puart);
+	}
 	ui_close (pserver->pui);
 	fb_clear (pserver->pfb);
 	fb_close (pserver->pfb);
@@ -14,11 +14,23 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <getopt.h>
 
-#define	SYSTEM_LOOP_DELAY_uS	100
+#define	TIME_DISPLAY_INTERVAL_mS	500
+#define	CMD_RETRY_INTERVAL_mS		2000
+
+/* epoll event source id */
+enum {
+	eEVENT_TIME_DISPLAY = 0,
+	eEVENT_CMD_RETRY,
+	eEVENT_UART_RX,
+};
 //------------------------------------------------------------------------------
 // for my lib
 //------------------------------------------------------------------------------
@@ -52,97 +64,567 @@
 #endif
 
 //------------------------------------------------------------------------------
-bool run_interval_check (struct timeval *t, double interval_ms)
+// Function prototype.
+//------------------------------------------------------------------------------
+void send_msg (jig_ch_t *pch, char cmd, __u8 cmd_id, char *pmsg);
+
+//------------------------------------------------------------------------------
+bool timer_set (int t_fd, int interval_ms, bool periodic)
 {
-	struct timeval base_time;
-	double difftime;
+	struct itimerspec its;
 
-	gettimeofday(&base_time, NULL);
+	memset (&its, 0, sizeof(its));
+	its.it_value.tv_sec  = interval_ms / 1000;
+	its.it_value.tv_nsec = (interval_ms % 1000) * 1000000;
+	if (periodic)
+		its.it_interval = its.it_value;
 
-	if (interval_ms) {
-		/* 현재 시간이 interval시간보다 크면 양수가 나옴 */
-		difftime = (base_time.tv_sec - t->tv_sec) +
-					((base_time.tv_usec - (t->tv_usec + interval_ms * 1000)) / 1000000);
+	/* interval_ms = 0 이면 timer 정지 */
+	return timerfd_settime (t_fd, 0, &its, NULL) ? false : true;
+}
 
-		if (difftime > 0) {
-			t->tv_sec  = base_time.tv_sec;
-			t->tv_usec = base_time.tv_usec;
-			return true;
-		}
-		return false;
-	}
-	/* 현재 시간 저장 */
-	t->tv_sec  = base_time.tv_sec;
-	t->tv_usec = base_time.tv_usec;
-	return true;
+//------------------------------------------------------------------------------
+// CLOCK_MONOTONIC 기준 현재 시간 (ms)
+//------------------------------------------------------------------------------
+__u64 time_ms (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (__u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+//------------------------------------------------------------------------------
+// CLOCK_MONOTONIC 기준 현재 시간 (us, command 응답시간 측정용)
+//------------------------------------------------------------------------------
+__u64 time_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (__u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+// 절대 시간(CLOCK_MONOTONIC, ms)에 1회 동작하는 timer 설정 (0 이면 timer 정지)
+//------------------------------------------------------------------------------
+bool timer_set_abs (int t_fd, __u64 expire_ms)
+{
+	struct itimerspec its;
+
+	memset (&its, 0, sizeof(its));
+	its.it_value.tv_sec  = expire_ms / 1000;
+	its.it_value.tv_nsec = (expire_ms % 1000) * 1000000;
+
+	return timerfd_settime (t_fd, TFD_TIMER_ABSTIME, &its, NULL) ? false : true;
+}
+
+//------------------------------------------------------------------------------
+bool epoll_add (int e_fd, int fd, __u32 id)
+{
+	struct epoll_event ev;
+
+	memset (&ev, 0, sizeof(ev));
+	ev.events   = EPOLLIN;
+	ev.data.u32 = id;
+	return epoll_ctl (e_fd, EPOLL_CTL_ADD, fd, &ev) ? false : true;
 }
 
 //------------------------------------------------------------------------------
 void time_display (jig_server_t *pserver)
 {
-	static struct timeval i_time;
 	static int i = 0;
 
-	if (run_interval_check(&i_time, 500)) {
+	{
 		time_t t = time(NULL);
 		struct tm tm = *localtime(&t);
-		ui_set_printf (pserver->pfb, pserver->pui, 0, "%s", pserver->model);
-		ui_set_printf (pserver->pfb, pserver->pui, 1, "%s", pserver->bdate);
-		ui_set_printf (pserver->pfb, pserver->pui, 2, "%02d:%02d:%02d",
+		/* render thread에서 frame 단위로 합쳐서 그림 (화면 갱신을 기다리지 않음) */
+		ui_post_printf (pserver->pui, 0, "%s", pserver->model);
+		ui_post_printf (pserver->pui, 1, "%s", pserver->bdate);
+		ui_post_printf (pserver->pui, 2, "%02d:%02d:%02d",
 			tm.tm_hour, tm.tm_min, tm.tm_sec);
 
 		if (i++ % 2) {
-			ui_set_ritem (pserver->pfb, pserver->pui, 0, COLOR_GREEN, -1);
-			ui_set_sitem (pserver->pfb, pserver->pui, 3, COLOR_RED, -1, "OFF");
+			ui_post_ritem (pserver->pui, 0, COLOR_GREEN, -1);
+			ui_post_sitem (pserver->pui, 3, COLOR_RED, -1, "OFF");
 		}
 		else {
-			ui_set_ritem (pserver->pfb, pserver->pui, 0, COLOR_RED, -1);
-			ui_set_sitem (pserver->pfb, pserver->pui, 3, COLOR_GREEN, -1, "ON");
+			ui_post_ritem (pserver->pui, 0, COLOR_RED, -1);
+			ui_post_sitem (pserver->pui, 3, COLOR_GREEN, -1, "ON");
 		}
 		info("%s\n", ctime(&t));
 	}
 }
 
 //------------------------------------------------------------------------------
-void catch_msg (ptc_var_t *var, __u8 *msg)
+void catch_msg (ptc_var_t *var, __s8 *msg)
 {
-	int i;
 	/* header & cmd는 제외 */
-	for (i = 0; i < PROTOCOL_DATA_SIZE; i++)
-		msg[i] = var->buf[(var->p_sp + 2 + i) % var->size];
+	memcpy (msg, &var->buf[2], PROTOCOL_DATA_SIZE);
+}
+
+//------------------------------------------------------------------------------
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+//------------------------------------------------------------------------------
+__u16 crc16 (const __u8 *d, int size)
+{
+	static const __u16 crc_nibble[16] = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+		0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	};
+	__u16 crc = 0xFFFF;
+
+	while (size--) {
+		crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*d   >> 4 )];
+		crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*d++ & 0xF)];
+	}
+	return crc;
+}
+
+//------------------------------------------------------------------------------
+// 7bit varint (최대 2 bytes). return : 사용한 byte 수, 0 = data 부족, -1 = error
+//------------------------------------------------------------------------------
+int varint_get (const __u8 *d, int size, __u32 *val)
+{
+	if (size < 1)	return 0;
+	if (!(d[0] & 0x80)) {
+		*val = d[0];
+		return 1;
+	}
+	if (size < 2)	return 0;
+	if (d[1] & 0x80)	return -1;
+
+	*val = (d[0] & 0x7F) | (d[1] << 7);
+	return 2;
+}
+
+//------------------------------------------------------------------------------
+int varint_put (__u8 *d, __u32 val)
+{
+	if (val < 0x80) {
+		d[0] = val;
+		return 1;
+	}
+	d[0] = (val & 0x7F) | 0x80;
+	d[1] = (val >> 7) & 0x7F;
+	return 2;
+}
+
+//------------------------------------------------------------------------------
+// binary frame 길이 (return : frame 길이, 0 = header 수신중, -1 = 잘못된 header)
+//------------------------------------------------------------------------------
+int bin_protocol_len (ptc_var_t *var)
+{
+	__u32 len;
+	int v_size;
+
+	if ((v_size = varint_get (&var->buf[1], var->len - 1, &len)) <= 0)
+		return v_size;
+
+	/* cmd, cmd_id, type은 항상 있어야 함 */
+	if ((len < 3) || (len > (BIN_PAYLOAD_MAX + 3)))
+		return -1;
+
+	return 1 + v_size + len + 2;
+}
+
+//------------------------------------------------------------------------------
+int bin_protocol_check (ptc_var_t *var)
+{
+	int f_size = bin_protocol_len (var);
+	__u16 crc;
+
+	if ((f_size <= 0) || (var->buf[0] != BIN_HEAD))
+		return 0;
+
+	crc = var->buf[f_size - 2] | (var->buf[f_size - 1] << 8);
+	return (crc16 (&var->buf[1], f_size - 3) == crc) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+int bin_protocol_catch (ptc_var_t *var)
+{
+	__u32 len = 0;
+	int v_size = varint_get (&var->buf[1], var->len - 1, &len), pos = 1 + v_size;
+
+	/* 길이 field를 모두 받지 못함 */
+	if (v_size <= 0)
+		return 0;
+
+	switch (var->buf[pos]) {
+		case 'O':	case 'A':	case 'R':	case 'B':	case 'E':	case 'V':
+		break;
+		default :
+			info ("%s : unknown resp = 0x%02x\n", __func__, var->buf[pos]);
+		return 0;
+	}
+	return 1;
+}
+
+//------------------------------------------------------------------------------
+// binary frame에서 cmd, cmd_id, payload를 얻는다. (text 이외의 payload는 hex 문자열)
+// return : false = 길이 field를 읽을 수 없는 frame (msg 사용 안함)
+//------------------------------------------------------------------------------
+bool bin_catch_msg (ptc_var_t *var, char *resp, int *cmd_id, __s8 *msg)
+{
+	__u32 len = 0, i;
+	/* pass 이후 var->len은 0 이므로 frame header에서 길이를 다시 얻는다. */
+	int v_size = varint_get (&var->buf[1], var->size - 1, &len), pos = 1 + v_size;
+	__u8 *payload = &var->buf[pos + 3];
+
+	if ((v_size <= 0) || (len < 3) || (len > (BIN_PAYLOAD_MAX + 3)))
+		return false;
+
+	*resp   = var->buf[pos];
+	*cmd_id = var->buf[pos + 1];
+	len    -= 3;
+
+	if (var->buf[pos + 2] == eBIN_TYPE_TEXT)
+		memcpy (msg, payload, len);
+	else
+		for (i = 0; (i < len) && ((i * 2) < (BIN_PAYLOAD_MAX - 1)); i++)
+			sprintf ((char *)&msg[i * 2], "%02x", payload[i]);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// ready handshake의 지원기능 목록(',' 구분)에서 cap을 찾는다.
+//------------------------------------------------------------------------------
+bool cap_find (const __s8 *caps, const char *cap)
+{
+	const char *p = (const char *)caps;
+	int c_len = strlen(cap);
+
+	while (p && *p) {
+		while (*p == ' ')
+			p++;
+		if (!strncmp (p, cap, c_len) && ((p[c_len] == ',') || !p[c_len]))
+			return true;
+		if ((p = strchr (p, ',')) != NULL)
+			p++;
+	}
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// ready handshake의 "name=value" 형식 기능 값 (없으면 0)
+//------------------------------------------------------------------------------
+__u32 cap_value (const __s8 *caps, const char *cap)
+{
+	const char *p = (const char *)caps;
+	int c_len = strlen(cap);
+
+	while (p && *p) {
+		while (*p == ' ')
+			p++;
+		if (!strncmp (p, cap, c_len) && (p[c_len] == '='))
+			return strtoul (&p[c_len + 1], NULL, 10);
+		if ((p = strchr (p, ',')) != NULL)
+			p++;
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// baud negotiation
+//------------------------------------------------------------------------------
+static const __u32 BaudTable[] = {
+	4000000, 3000000, 2500000, 2000000, 1500000, 1152000,
+	1000000,  921600,  576000,  500000,  460800,  230400, 0
+};
+
+//------------------------------------------------------------------------------
+// link error 수 (현재 사용중인 frame 형식의 잘못된 frame + 응답없는 keepalive)
+// command retry는 DUT의 처리 시간에 따라 발생할 수 있으므로 포함하지 않는다.
+//------------------------------------------------------------------------------
+__u32 baud_err_cnt (jig_ch_t *pch)
+{
+	int ptc_num = pch->bin_mode ? ePTC_BINARY : ePTC_ASCII;
+
+	return pch->puart->p[ptc_num].var.err_cnt + pch->baud.lost;
+}
+
+//------------------------------------------------------------------------------
+bool baud_change (jig_ch_t *pch, __u32 rate)
+{
+	/* 전송중인 frame은 현재 baud로 모두 보낸 후 변경 */
+	uart_tx_drain (pch->puart, BAUD_TIMEOUT_mS);
+	if (!uart_set_baud (pch->puart, rate))
+		return false;
+
+	pch->baud.rate     = rate;
+	pch->baud.err_mark = baud_err_cnt (pch);
+	info ("ch %d : uart baud = %d bps\n", pch->id, rate);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// limit 이하의 다음 baud로 negotiation 시작 (없으면 종료)
+//------------------------------------------------------------------------------
+void baud_start (jig_ch_t *pch)
+{
+	char buf[16];
+	int i;
+
+	pch->baud.state  = eBAUD_IDLE;
+	pch->baud.target = 0;
+	for (i = 0; BaudTable[i]; i++) {
+		if ((BaudTable[i] <= pch->baud.limit) && (BaudTable[i] > BAUD_BASE)) {
+			pch->baud.target = BaudTable[i];
+			break;
+		}
+	}
+	if (!pch->baud.target)
+		return;
+
+	sprintf (buf, "%u", pch->baud.target);
+	send_msg (pch, 'S', CMD_ID_CTRL, buf);
+	pch->baud.state    = eBAUD_WAIT_ACK;
+	pch->baud.deadline = time_ms() + BAUD_TIMEOUT_mS;
 }
 
 //------------------------------------------------------------------------------
-void recv_msg_check (jig_server_t *pserver, __s8 *msg, int ch)
+// 실패 : BAUD_BASE로 복귀하고 client 복귀 시간 후 더 낮은 baud로 재시도
+// (client는 COMMIT 또는 KEEPALIVE가 없으면 스스로 복귀하므로 복귀 요청은 보내지 않음)
+//------------------------------------------------------------------------------
+void baud_fallback (jig_ch_t *pch)
 {
-	ptc_grp_t *ptc_grp = pserver->puart[ch];
-	__u8 idata, p_cnt;
+	info ("ch %d : baud %d fail, fallback to %d\n",
+			pch->id, pch->baud.rate, BAUD_BASE);
+
+	pch->baud.limit    = pch->baud.target ? pch->baud.target - 1 : pch->baud.rate - 1;
+	baud_change (pch, BAUD_BASE);
+	pch->baud.state    = eBAUD_SETTLE;
+	pch->baud.deadline = time_ms() + BAUD_SETTLE_mS;
+}
 
-	/* uart data processing */
-	if (queue_get (&ptc_grp->rx_q, &idata))
-		ptc_event (ptc_grp, idata);
+//------------------------------------------------------------------------------
+void baud_msg_check (jig_ch_t *pch, char resp, __s8 *payload)
+{
+	char buf[PROTOCOL_DATA_SIZE];
+	int i;
 
-	for (p_cnt = 0; p_cnt < ptc_grp->pcnt; p_cnt++) {
-		if (ptc_grp->p[p_cnt].var.pass) {
-			__s8 *ptr, cmd_id;
+	switch (pch->baud.state) {
+		case	eBAUD_WAIT_ACK:
+			if (resp == 'E') {
+				/* 지원하지 않는 baud : 더 낮은 baud로 재시도 */
+				pch->baud.limit = pch->baud.target - 1;
+				baud_start (pch);
+				break;
+			}
+			if ((resp != 'A') || !baud_change (pch, pch->baud.target)) {
+				baud_fallback (pch);
+				break;
+			}
+			/* 변경된 baud로 verify burst 전송 */
+			for (i = 0; i < BAUD_VERIFY_COUNT; i++) {
+				sprintf (buf, "VERIFY,%d", i);
+				send_msg (pch, 'V', CMD_ID_CTRL, buf);
+			}
+			pch->baud.verify   = 0;
+			pch->baud.state    = eBAUD_VERIFY;
+			pch->baud.deadline = time_ms() + BAUD_TIMEOUT_mS;
+		break;
+		case	eBAUD_VERIFY:
+			sprintf (buf, "VERIFY,%d", pch->baud.verify);
+			if ((resp != 'V') || strncmp ((char *)payload, buf, strlen(buf))) {
+				baud_fallback (pch);
+				break;
+			}
+			/* client는 COMMIT을 받아야 변경된 baud를 유지한다. */
+			if (++pch->baud.verify == BAUD_VERIFY_COUNT) {
+				send_msg (pch, 'V', CMD_ID_CTRL, "COMMIT");
+				pch->baud.state    = eBAUD_COMMIT;
+				pch->baud.deadline = time_ms() + BAUD_TIMEOUT_mS;
+			}
+		break;
+		case	eBAUD_COMMIT:
+			if ((resp != 'V') || strncmp ((char *)payload, "COMMIT", strlen("COMMIT"))) {
+				baud_fallback (pch);
+				break;
+			}
+			pch->baud.state     = eBAUD_IDLE;
+			pch->baud.keepalive = false;
+			pch->baud.err_mark  = baud_err_cnt (pch);
+			pch->baud.deadline  = time_ms() + BAUD_KEEPALIVE_mS;
+			info ("ch %d : baud negotiation done (%d bps)\n",
+					pch->id, pch->baud.rate);
+		break;
+		case	eBAUD_IDLE:
+			if ((resp == 'V') && !strncmp ((char *)payload, "KEEPALIVE", strlen("KEEPALIVE")))
+				pch->baud.keepalive = false;
+		break;
+		default :
+		break;
+	}
+}
 
-			catch_msg (&ptc_grp->p[p_cnt].var, msg);
-			info ("pass message = %s\n", msg);
+//------------------------------------------------------------------------------
+// negotiation timeout 및 link error 검사 (return : negotiation 진행중)
+//------------------------------------------------------------------------------
+bool baud_check (jig_ch_t *pch, __u64 now)
+{
+	if ((pch->baud.state == eBAUD_IDLE) && (pch->baud.rate > BAUD_BASE) &&
+		(now >= pch->baud.deadline)) {
+		/* 이전 keepalive의 응답이 없으면 link error */
+		if (pch->baud.keepalive)
+			pch->baud.lost++;
+		send_msg (pch, 'V', CMD_ID_CTRL, "KEEPALIVE");
+		pch->baud.keepalive = true;
+		pch->baud.deadline  = now + BAUD_KEEPALIVE_mS;
+	}
 
-			ptc_grp->p[p_cnt].var.pass = false;
-			ptc_grp->p[p_cnt].var.open = true;
-			#if 0
-			/*
-				cmd & cmd_id check;
-			*/
-			ptr = strtok (msg, ",");	cmd_id = atoi(ptr);
+	if ((pch->baud.state == eBAUD_IDLE) && (pch->baud.rate > BAUD_BASE) &&
+		((baud_err_cnt (pch) - pch->baud.err_mark) >= BAUD_ERR_MAX)) {
+		pch->baud.target = pch->baud.rate;
+		baud_fallback (pch);
+	}
 
-			ptr = strtok (NULL, ",");
-			if (!strncmp(ptr,  "GPIO", strlen("GPIO")))	run_gpio_cmd (pclient, cmd_id);
-			if (!strncmp(ptr,   "USB", strlen("USB")))	run_usb_cmd  (pclient, cmd_id);
-			if (!strncmp(ptr,  "UART", strlen("UART")))	run_uart_cmd (pclient, cmd_id);
-			#endif
-			memset(msg, 0, PROTOCOL_DATA_SIZE);
+	if ((pch->baud.state != eBAUD_IDLE) && (now >= pch->baud.deadline)) {
+		switch (pch->baud.state) {
+			case	eBAUD_WAIT_ACK:
+				/* 응답 없음 : baud negotiation을 지원하지 않음 */
+				info ("ch %d : baud negotiation not supported.\n", pch->id);
+				pch->baud.state = eBAUD_IDLE;
+			break;
+			case	eBAUD_VERIFY:	case	eBAUD_COMMIT:
+				baud_fallback (pch);
+			break;
+			case	eBAUD_SETTLE:
+				baud_start (pch);
+			break;
+			default :
+			break;
+		}
+	}
+	return (pch->baud.state != eBAUD_IDLE) ? true : false;
+}
+
+//------------------------------------------------------------------------------
+jig_slot_t *find_slot (jig_ch_t *pch, int cmd_id)
+{
+	int i;
+
+	for (i = 0; i < pch->pserver->cmd_window; i++)
+		if (pch->slot[i].cmd_id == cmd_id)
+			return &pch->slot[i];
+	return NULL;
+}
+
+//------------------------------------------------------------------------------
+// 응답 message의 cmd_id로 in-flight command를 찾아 처리
+//------------------------------------------------------------------------------
+void resp_msg_check (jig_ch_t *pch, char resp, int cmd_id, __s8 *payload)
+{
+	jig_slot_t *slot;
+	int i;
+
+	switch (resp) {
+		case 'O':	pch->result.okay_cnt++;		break;
+		case 'A':	pch->result.ack_cnt++;		break;
+		case 'B':	pch->result.busy_cnt++;		break;
+		case 'E':	pch->result.error_cnt++;	break;
+		case 'R':	pch->result.ready_cnt++;	break;
+		default :								break;
+	}
+
+	/* DUT reboot : 응답을 기다리던 command를 모두 바로 재전송 */
+	if (resp == 'R') {
+		bool bin_mode = cap_find (payload, "BIN");
+
+		/* DUT는 boot후 BAUD_BASE를 사용한다. */
+		if (pch->baud.rate != BAUD_BASE)
+			baud_change (pch, BAUD_BASE);
+
+		/* DUT는 boot후 항상 ASCII frame을 사용하므로 응답은 ASCII로 보낸다. */
+		pch->bin_mode = false;
+		send_msg (pch, 'R', 0, bin_mode ? "BIN" : "ASCII");
+		pch->bin_mode = bin_mode;
+		info ("ch %d : ready, frame = %s\n", pch->id, bin_mode ? "BIN" : "ASCII");
+
+		for (i = 0; i < pch->pserver->cmd_window; i++)
+			if (pch->slot[i].cmd_id >= 0)
+				pch->slot[i].deadline = 0;
+
+		/* DUT와 server가 모두 지원하는 최대 baud로 negotiation */
+		pch->baud.limit = cap_value (payload, "BAUD");
+		if (pch->baud.limit > pch->pserver->baud_max)
+			pch->baud.limit = pch->pserver->baud_max;
+		baud_start (pch);
+		return;
+	}
+
+	if (cmd_id == CMD_ID_CTRL) {
+		baud_msg_check (pch, resp, payload);
+		return;
+	}
+
+	if ((slot = find_slot (pch, cmd_id)) == NULL) {
+		info ("ch %d : unknown cmd_id response (%d)\n", pch->id, cmd_id);
+		return;
+	}
+
+	switch (resp) {
+		/* command 완료 */
+		case 'O':	case 'E':
+			pch->cmd_result[slot->cmd_id] = resp;
+			pch->cmd_rtt[slot->cmd_id] = (__u32)(time_us() - slot->sent_us);
+			pch->cmd_done++;
+			slot->cmd_id = -1;
+			if (pch->cmd_done == pch->pserver->cmd_cnt)
+				info ("ch %d : all command done (okay = %d, error = %d, retry = %d)\n",
+					pch->id, pch->result.okay_cnt, pch->result.error_cnt,
+					pch->result.retry_cnt);
+		break;
+		/* DUT에서 실행중 또는 처리 불가 : 응답 대기시간 연장 후 재전송 */
+		case 'A':	case 'B':
+			slot->deadline = time_ms() + CMD_RETRY_INTERVAL_mS;
+		break;
+		default :
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+void recv_msg_check (jig_ch_t *pch)
+{
+	ptc_grp_t *ptc_grp = pch->puart;
+	__s8 msg[BIN_PAYLOAD_MAX + 1], *payload;
+	__u8 *data, p_cnt;
+	__u32 size;
+	char resp;
+	int cmd_id;
+
+	/* uart data processing (rx queue에 쌓여있는 data를 모두 처리) */
+	while ((size = queue_peek (&ptc_grp->rx_q, &data)) > 0) {
+		queue_drop (&ptc_grp->rx_q, ptc_event (ptc_grp, data, size));
+
+		for (p_cnt = 0; p_cnt < ptc_grp->pcnt; p_cnt++) {
+			if (ptc_grp->p[p_cnt].var.pass) {
+				memset (msg, 0, sizeof(msg));
+				if (p_cnt == ePTC_BINARY) {
+					if (!bin_catch_msg (&ptc_grp->p[p_cnt].var, &resp, &cmd_id, msg)) {
+						err ("ch %d : binary frame length error!\n", pch->id);
+						ptc_grp->p[p_cnt].var.pass = false;
+						ptc_grp->p[p_cnt].var.open = true;
+						continue;
+					}
+					payload = msg;
+				} else {
+					/* msg = "%03d,..." */
+					catch_msg (&ptc_grp->p[p_cnt].var, msg);
+					resp    = ptc_grp->p[p_cnt].var.buf[1];
+					cmd_id  = strtol ((char *)msg, NULL, 10);
+					payload = (msg[3] == ',') ? &msg[4] : &msg[3];
+				}
+				info ("ch %d : pass message = %c, %03d, %s\n",
+						pch->id, resp, cmd_id, payload);
+
+				resp_msg_check (pch, resp, cmd_id, payload);
+
+				ptc_grp->p[p_cnt].var.pass = false;
+				ptc_grp->p[p_cnt].var.open = true;
+			}
 		}
 	}
 }
@@ -152,22 +634,19 @@ void recv_msg_check (jig_server_t *pserver, __s8 *msg, int ch)
 int protocol_check(ptc_var_t *var)
 {
 	/* head & tail check with protocol size */
-	if(var->buf[(var->p_sp + var->size -1) % var->size] != '#')	return 0;
-	if(var->buf[(var->p_sp               ) % var->size] != '@')	return 0;
+	if(var->buf[var->size -1] != '#')	return 0;
+	if(var->buf[0           ] != '@')	return 0;
 	return 1;
 }
 
 //------------------------------------------------------------------------------
 int protocol_catch(ptc_var_t *var)
 {
-	int i;
-	char resp = var->buf[(var->p_sp + 1) % var->size];
+	char resp = var->buf[1];
 
 	switch (resp) {
 		case 'O':
-			for (i = 2; i < var->size -2; i++) {
-				printf("%c", var->buf[(var->p_sp +i) % var->size]);
-			}
+			printf("%.*s", (int)(var->size - 3), &var->buf[2]);
 		break;
 		case 'A':	case 'R':	case 'B':
 		default :
@@ -178,12 +657,45 @@ int protocol_catch(ptc_var_t *var)
 }
 
 //------------------------------------------------------------------------------
-void send_msg (jig_server_t *pserver, char cmd, __u8 cmd_id, char *pmsg)
+void send_bin_msg (jig_ch_t *pch, char cmd, __u8 cmd_id, __u8 type,
+					const void *payload, int size)
+{
+	__u8 frame[BIN_FRAME_MAX];
+	__u16 crc;
+	int pos;
+
+	size = (size > BIN_PAYLOAD_MAX) ? BIN_PAYLOAD_MAX : size;
+
+	frame[0] = BIN_HEAD;
+	pos  = 1 + varint_put (&frame[1], size + 3);
+	frame[pos++] = cmd;
+	frame[pos++] = cmd_id;
+	frame[pos++] = type;
+	memcpy (&frame[pos], payload, size);
+	pos += size;
+
+	crc = crc16 (&frame[1], pos - 1);
+	frame[pos++] = crc & 0xFF;
+	frame[pos++] = crc >> 8;
+
+	if (uart_send (pch->puart, frame, pos) != (__u32)pos)
+		err ("ch %d : tx queue overflow!\n", pch->id);
+}
+
+//------------------------------------------------------------------------------
+void send_msg (jig_ch_t *pch, char cmd, __u8 cmd_id, char *pmsg)
 {
 	protocol_t s;
 	int m_size, pos;
 	__u8 *p = (__u8 *)&s;
 
+	/* binary frame은 padding 없이 message 크기만큼만 전송 */
+	if (pch->bin_mode) {
+		send_bin_msg (pch, cmd, cmd_id, eBIN_TYPE_TEXT,
+						pmsg, (pmsg != NULL) ? strlen(pmsg) : 0);
+		return;
+	}
+
 	memset (&s, 0, sizeof(protocol_t));
 	s.head = '@';	s.tail = '#';
 	s.cmd  = cmd;
@@ -196,57 +708,209 @@ void send_msg (jig_server_t *pserver, char cmd, __u8 cmd_id, char *pmsg)
 							(PROTOCOL_DATA_SIZE - pos) : m_size;
 		strncpy (&s.data[pos], pmsg, m_size);
 	}
-	for (m_size = 0; m_size < sizeof(protocol_t); m_size++) {
-		queue_put(&pserver->puart[0]->tx_q, p + m_size);
+	if (uart_send (pch->puart, p, sizeof(protocol_t)) != sizeof(protocol_t))
+		err ("ch %d : tx queue overflow!\n", pch->id);
+}
+
+//------------------------------------------------------------------------------
+// window에 빈 slot이 있으면 다음 command를 전송하고, deadline이 지난 command는
+// 재전송한다. retry timer는 가장 빠른 deadline으로 설정.
+//------------------------------------------------------------------------------
+void send_msg_check (jig_ch_t *pch)
+{
+	jig_server_t *pserver = pch->pserver;
+	__u64 now = time_ms(), expire = 0;
+	jig_slot_t *slot;
+	int i;
+
+	/* baud negotiation 중에는 command를 전송하지 않는다. */
+	if (baud_check (pch, now)) {
+		timer_set_abs (pch->retry_fd, pch->baud.deadline);
+		return;
 	}
+
+	for (i = 0; i < pserver->cmd_window; i++) {
+		slot = &pch->slot[i];
+
+		if (slot->cmd_id < 0) {
+			if (pch->cmd_id >= pserver->cmd_cnt)
+				continue;
+			slot->cmd_id  = pch->cmd_id++;
+			slot->sent_us = time_us();
+		}
+		else if (slot->deadline > now)
+			goto next;
+		else {
+			info ("ch %d : Retry Send.... \n", pch->id);
+			pch->result.retry_cnt++;
+		}
+
+		info ("%s : ch %d, send id %d, msg = %s, protocol_size = %ld\n", __func__,
+				pch->id, slot->cmd_id, pserver->cmds[slot->cmd_id], sizeof(protocol_t));
+		send_msg (pch, 'C', slot->cmd_id, pserver->cmds[slot->cmd_id]);
+		pch->result.tx_cnt++;
+		/* 응답이 없는 경우 retry */
+		slot->deadline = now + CMD_RETRY_INTERVAL_mS;
+next:
+		if (!expire || (slot->deadline < expire))
+			expire = slot->deadline;
+	}
+	/* 변경된 baud에서는 keepalive 전송 시간 */
+	if ((pch->baud.rate > BAUD_BASE) && (!expire || (pch->baud.deadline < expire)))
+		expire = pch->baud.deadline;
+	timer_set_abs (pch->retry_fd, expire);
 }
 
 //------------------------------------------------------------------------------
-void send_msg_check (jig_server_t *pserver)
+// channel service thread (channel마다 독립된 epoll loop)
+//------------------------------------------------------------------------------
+void *ch_thread_func (void *arg)
 {
-	static struct timeval i_time;
+	jig_ch_t *pch = (jig_ch_t *)arg;
+	struct epoll_event events[4];
+	eventfd_t cnt;
+	int i, n;
+
+	send_msg_check (pch);
 
-	if (pserver->cmd_run) {
-		if (run_interval_check(&i_time, 2000)) {
-			info ("Retry Send.... \n");
-			goto retry;
+	/* event가 없는 동안은 epoll_wait에서 sleep */
+	while (1) {
+		if ((n = epoll_wait (pch->e_fd, events, sizeof(events)/sizeof(events[0]), -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err ("ch %d : epoll_wait error! (%s)\n", pch->id, strerror(errno));
+			break;
 		}
-		return;
+
+		for (i = 0; i < n; i++) {
+			switch (events[i].data.u32) {
+				case	eEVENT_CMD_RETRY:
+					read (pch->retry_fd, &cnt, sizeof(cnt));
+				break;
+				case	eEVENT_UART_RX:
+					/* uart data processing */
+					eventfd_read (pch->puart->rx_efd, &cnt);
+					recv_msg_check (pch);
+				break;
+				default :
+				break;
+			}
+		}
+		send_msg_check (pch);
 	}
+	return NULL;
+}
+
+//------------------------------------------------------------------------------
+bool ch_init (jig_server_t *pserver, jig_ch_t *pch)
+{
+	int i;
+
+	pch->pserver = pserver;
+	pch->baud.rate = BAUD_BASE;
+	for (i = 0; i < CMD_WINDOW_MAX; i++)
+		pch->slot[i].cmd_id = -1;
 
-retry:
-	info ("%s : send id %d, msg = %s, protocol_size = %ld\n", __func__,
-			pserver->cmd_id, pserver->cmds[pserver->cmd_id], sizeof(protocol_t));
-	if (pserver->cmd_id < CMD_COUNT_MAX) {
-		send_msg (pserver, 'C', pserver->cmd_id, pserver->cmds[pserver->cmd_id]);
-		pserver->cmd_run = true;
-		run_interval_check (&i_time, 0);
+	/* ASCII frame은 DUT boot시 사용되므로 binary frame과 함께 항상 수신 */
+	if (!ptc_grp_init (pch->puart, ePTC_END))
+		return false;
+	if (!ptc_func_init (pch->puart, ePTC_ASCII, sizeof(protocol_t), '@',
+						protocol_check, protocol_catch))
+		return false;
+	if (!ptc_func_init (pch->puart, ePTC_BINARY, BIN_FRAME_MAX, BIN_HEAD,
+						bin_protocol_check, bin_protocol_catch))
+		return false;
+	ptc_func_len (pch->puart, ePTC_BINARY, bin_protocol_len);
+
+	pch->e_fd     = epoll_create1 (EPOLL_CLOEXEC);
+	pch->retry_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if ((pch->e_fd < 0) || (pch->retry_fd < 0)) {
+		err ("ch %d : epoll/timerfd create error!\n", pch->id);
+		return false;
 	}
+	epoll_add (pch->e_fd, pch->retry_fd, eEVENT_CMD_RETRY);
+	epoll_add (pch->e_fd, pch->puart->rx_efd, eEVENT_UART_RX);
+
+	if (pthread_create (&pch->thread, NULL, ch_thread_func, pch))
+		return false;
+	pch->started = true;
+	return true;
 }
 
 //------------------------------------------------------------------------------
-int server_main (jig_server_t *pserver)
+// channel thread 종료 (uart는 호출한 곳에서 닫는다, ch_init 실패/중복 호출 가능)
+//------------------------------------------------------------------------------
+void ch_close (jig_ch_t *pch)
 {
-	__s8 MsgData[PROTOCOL_DATA_SIZE];
+	/* channel thread는 epoll_wait에서 대기중 */
+	if (pch->started) {
+		pthread_cancel (pch->thread);
+		pthread_join (pch->thread, NULL);
+		pch->started = false;
+	}
+
+	if (pch->retry_fd > 0)
+		close (pch->retry_fd);
+	if (pch->e_fd > 0)
+		close (pch->e_fd);
+	pch->retry_fd = pch->e_fd = -1;
+}
 
-	if (ptc_grp_init (pserver->puart[0], 1)) {
-		if (!ptc_func_init (pserver->puart[0], 0, sizeof(protocol_t), 
-    							protocol_check, protocol_catch))
-			return 0;
+//------------------------------------------------------------------------------
+int server_main (jig_server_t *pserver)
+{
+	struct epoll_event events[4];
+	int e_fd, t_fd, ch, i, n;
+	eventfd_t cnt;
+
+	/* 모든 channel은 각자의 thread에서 동시에 처리된다. */
+	for (ch = 0; ch < pserver->ch_cnt; ch++) {
+		if (!ch_init (pserver, &pserver->ch[ch])) {
+			err ("ch %d : channel init fail!\n", ch);
+			/* 이미 시작된 channel thread 종료 (실패한 channel의 fd 포함) */
+			while (ch >= 0)
+				ch_close (&pserver->ch[ch--]);
+			return -1;
+		}
 	}
 
-	while (1) {
-		time_display(pserver);
+	e_fd = epoll_create1 (EPOLL_CLOEXEC);
+	t_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if ((e_fd < 0) || (t_fd < 0)) {
+		err ("epoll/timerfd create error!\n");
+		if (e_fd >= 0)	close (e_fd);
+		if (t_fd >= 0)	close (t_fd);
+		for (ch = 0; ch < pserver->ch_cnt; ch++)
+			ch_close (&pserver->ch[ch]);
+		return -1;
+	}
 
-		/* uart data processing */
-		recv_msg_check(pserver, MsgData, 0);
-		if (pserver->dual_ch)
-			recv_msg_check(pserver, MsgData, 1);
+	epoll_add (e_fd, t_fd, eEVENT_TIME_DISPLAY);
+	timer_set (t_fd, TIME_DISPLAY_INTERVAL_mS, true);
+	time_display (pserver);
 
-		send_msg_check (pserver);
+	/* event가 없는 동안은 epoll_wait에서 sleep */
+	while (1) {
+		if ((n = epoll_wait (e_fd, events, sizeof(events)/sizeof(events[0]), -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err ("epoll_wait error! (%s)\n", strerror(errno));
+			break;
+		}
 
-		usleep(SYSTEM_LOOP_DELAY_uS);
+		for (i = 0; i < n; i++) {
+			switch (events[i].data.u32) {
+				case	eEVENT_TIME_DISPLAY:
+					if (read (t_fd, &cnt, sizeof(cnt)) > 0)
+						time_display (pserver);
+				break;
+				default :
+				break;
+			}
+		}
 	}
+	close (t_fd);
+	close (e_fd);
 	return 0;
 }
 
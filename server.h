@@ -37,35 +37,185 @@ typedef struct protocol__t {
 	__s8	tail;
 }	protocol_t;
 
+/*
+	binary frame (ready handshake에서 client가 "BIN"을 지원하는 경우 사용)
+
+	'$' | len(varint) | cmd | cmd_id | type | payload[len - 3] | crc16(LE)
+
+	len   : cmd ~ payload 크기 (7bit varint, 최대 2 bytes)
+	crc16 : CRC-16/CCITT-FALSE (len ~ payload)
+
+	ready handshake:
+		client to server : 'R', "000,BIN"   (지원 기능 목록)
+		server to client : 'R', "000,BIN" or "000,ASCII" (선택된 frame 형식)
+		client는 server의 'R' 응답 이후부터 선택된 형식으로 전송한다.
+
+	baud negotiation (client의 ready 기능 목록에 "BAUD=최대baud"가 있는 경우):
+		server to client : 'S', "255,{baud}"     (cmd_id 255 = control)
+		client to server : 'A' (변경함) or 'E' (지원안함), 응답 후 client는 baud 변경
+		server to client : 'V', "255,VERIFY,{n}" x BAUD_VERIFY_COUNT (변경된 baud)
+		client to server : 'V', 받은 payload 그대로 응답
+		server to client : 'V', "255,COMMIT"    (모든 verify 응답이 맞는 경우)
+		client to server : 'V', "255,COMMIT"
+		server to client : 'V', "255,KEEPALIVE" (COMMIT 이후 BAUD_KEEPALIVE_mS 마다)
+		client to server : 'V', "255,KEEPALIVE"
+
+		client는 baud 변경 후 BAUD_TIMEOUT_mS 안에 COMMIT을 받지 못하거나,
+		COMMIT 이후 BAUD_TIMEOUT_mS 동안 KEEPALIVE를 받지 못하면 BAUD_BASE로 복귀한다.
+		server는 verify/COMMIT 실패 또는 link error 증가시 아무것도 보내지 않고
+		BAUD_BASE로 복귀하며, client가 복귀할 때까지(BAUD_SETTLE_mS) 기다린 후
+		낮은 baud로 재시도한다. (복귀 요청은 손상된 link로 전달되지 않을 수 있음)
+*/
+#define	BIN_HEAD			'$'
+#define	BIN_PAYLOAD_MAX		64
+#define	BIN_FRAME_MAX		(1 + 2 + 3 + BIN_PAYLOAD_MAX + 2)
+
+/* binary payload type */
+enum {
+	eBIN_TYPE_NONE = 0,
+	eBIN_TYPE_TEXT,
+	/* little-endian __u32 array */
+	eBIN_TYPE_U32,
+};
+
+/* baud negotiation */
+#define	BAUD_BASE			115200
+#define	BAUD_VERIFY_COUNT	4
+#define	BAUD_TIMEOUT_mS		500
+#define	BAUD_KEEPALIVE_mS	(BAUD_TIMEOUT_mS / 4)
+/* client의 복귀 시간(BAUD_TIMEOUT_mS) + 마지막 frame의 전송 시간 여유 */
+#define	BAUD_SETTLE_mS		(BAUD_TIMEOUT_mS * 2)
+/* 변경된 baud에서 link error(잘못된 frame + 응답없는 keepalive)가 이 값 이상이면 BAUD_BASE로 복귀 */
+#define	BAUD_ERR_MAX		8
+#define	CMD_ID_CTRL			255
+
+enum {
+	eBAUD_IDLE = 0,
+	/* 'S' 전송 후 client 응답 대기 */
+	eBAUD_WAIT_ACK,
+	/* 변경된 baud에서 verify frame 응답 대기 */
+	eBAUD_VERIFY,
+	/* COMMIT 전송 후 client 응답 대기 */
+	eBAUD_COMMIT,
+	/* 실패 후 client가 BAUD_BASE로 복귀할 때까지 대기 */
+	eBAUD_SETTLE,
+};
+
+/* uart protocol number */
+enum {
+	ePTC_ASCII = 0,
+	ePTC_BINARY,
+	ePTC_END
+};
+
 //------------------------------------------------------------------------------
 #define	CMD_COUNT_MAX	128
+#define	CH_COUNT_MAX	16
+/* channel당 동시에 응답을 기다릴 수 있는 최대 command 수 */
+#define	CMD_WINDOW_MAX	8
+
+/* channel별 test 결과 기록 */
+typedef struct jig_result__t {
+	/* command 전송 / retry 횟수 */
+	int			tx_cnt, retry_cnt;
+	/* 수신 응답 ('O'kay, 'A'ck, 'B'usy, 'E'rror, 'R'eady) */
+	int			okay_cnt, ack_cnt, busy_cnt, error_cnt, ready_cnt;
+}	jig_result_t;
+
+/* 응답을 기다리는 command (in-flight) */
+typedef struct jig_slot__t {
+	/* -1 = empty slot */
+	int			cmd_id;
+	/* 응답이 없으면 재전송할 시간 (CLOCK_MONOTONIC, ms) */
+	__u64		deadline;
+	/* 처음 전송한 시간 (CLOCK_MONOTONIC, us) */
+	__u64		sent_us;
+}	jig_slot_t;
+
+/* channel uart baud 상태 */
+typedef struct jig_baud__t {
+	int			state;
+	/* 현재 baud, 협상 가능한 최대 baud, 협상중인 baud */
+	__u32		rate, limit, target;
+	/* 확인된 verify frame 수 */
+	int			verify;
+	/* negotiation 단계의 timeout, 또는 (eBAUD_IDLE) 다음 keepalive 전송 시간 */
+	__u64		deadline;
+	/* 응답을 기다리는 keepalive, 응답이 없었던 keepalive 수 */
+	bool		keepalive;
+	__u32		lost;
+	/* baud 변경 시점의 link error 수 */
+	__u32		err_mark;
+}	jig_baud_t;
+
+struct jig_server__t;
+
+/* DUT 1개에 대한 channel (channel마다 독립된 thread에서 처리) */
+typedef struct jig_channel__t {
+	int			id;
+	/* UART dev node */
+	char		uart_dev[32];
+	/* I2C dev node */
+	char		adc_dev[32];
+
+	ptc_grp_t	*puart;
+
+	/* channel service thread, epoll (started = thread 실행중) */
+	pthread_t	thread;
+	bool		started;
+	int			e_fd;
+	/* command retry timer (timerfd) */
+	int			retry_fd;
+
+	/* binary frame 사용 (ready handshake에서 결정) */
+	bool		bin_mode;
+	jig_baud_t	baud;
+
+	/* command cursor (다음에 전송할 cmd_id) */
+	int			cmd_id;
+	/* in-flight command window */
+	jig_slot_t	slot[CMD_WINDOW_MAX];
+	/* command별 결과 ('O'kay, 'E'rror, 0 = 결과 없음) */
+	char		cmd_result[CMD_COUNT_MAX];
+	/* command별 응답시간 (처음 전송부터 완료까지, us) */
+	__u32		cmd_rtt[CMD_COUNT_MAX];
+	int			cmd_done;
+
+	jig_result_t	result;
+	struct jig_server__t	*pserver;
+}	jig_ch_t;
 
 typedef struct jig_server__t {
 	/* build info */
 	char		bdate[32], btime[32];
 	/* JIG model name */
 	char		model[32];
-	/* JIG is dual channel? */
-	bool		dual_ch;
-	/* UART dev node */
-	char		uart_dev[2][32];
-	/* I2C dev node */
-	char		adc_dev[2][32];
-	/* FB dev node */
-	char		fb_dev[32];
+	/* FB dev node (/dev/fbN, mem:{w}x{h}x{bpp}, file:{w}x{h}x{bpp}:{path}) */
+	char		fb_dev[FB_DUMP_PATH_MAX + 32];
 
 	fb_info_t	*pfb;
 	ui_grp_t	*pui;
-	ptc_grp_t	*puart[2];
 
-	bool		cmd_run;
-	char		cmd_id;
+	/* JIG channel (DUT) count */
+	int			ch_cnt;
+	jig_ch_t	ch[CH_COUNT_MAX];
+
+	/* baud negotiation 최대 baud (BAUD_BASE = negotiation 안함) */
+	__u32		baud_max;
+	/* channel당 in-flight command 수 (1 = stop-and-wait) */
+	int			cmd_window;
 	char		cmd_cnt;
 	char		cmds[CMD_COUNT_MAX][PROTOCOL_DATA_SIZE];
 }	jig_server_t;
 
 //------------------------------------------------------------------------------
-extern  int server_main (jig_server_t *pserver);
+extern  __u64   time_us     (void);
+extern  __u16   crc16       (const __u8 *d, int size);
+extern  int     varint_get  (const __u8 *d, int size, __u32 *val);
+extern  int     varint_put  (__u8 *d, __u32 val);
+extern  bool    ch_init     (jig_server_t *pserver, jig_ch_t *pch);
+extern  void    ch_close    (jig_ch_t *pch);
+extern  int     server_main (jig_server_t *pserver);
 
 //------------------------------------------------------------------------------
 #endif  // #define __SERVER_H__
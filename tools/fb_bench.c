@@ -0,0 +1,328 @@
+//------------------------------------------------------------------------------
+/**
+ * @file fb_bench.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief lib_fb / lib_ui rendering benchmark.
+ *
+ *        memory framebuffer(mem:{w}x{h}x{bpp})에 draw_fill_rect, draw_text,
+ *        ui_update(-1), ui_set_printf를 반복 실행하여
+ *        ns/pixel, glyphs/s, 전체 화면 갱신 시간을 측정한다.
+ * @version 0.1
+ * @date 2022-05-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "typedefs.h"
+#include "lib_fb.h"
+#include "lib_ui.h"
+
+//------------------------------------------------------------------------------
+#define	TEXT_GLYPH_MAX		64
+#define	UTF8_HANGUL_SIZE	3
+
+//------------------------------------------------------------------------------
+// Default global value
+//------------------------------------------------------------------------------
+/* 항목별 최소 측정 시간 (ms) */
+int		OPT_TIME_mS		= 200;
+/* 0 이면 전체 해상도 / bpp */
+int		OPT_WIDTH		= 0;
+int		OPT_HEIGHT		= 0;
+int		OPT_BPP			= 0;
+char	*OPT_UI_CFG_FILE	= "default_ui.cfg";
+bool	OPT_VERBOSE		= false;
+
+static const int Resolution[][2] = {
+	{  800,  480 },
+	{ 1920, 1080 },
+	{ 3840, 2160 },
+};
+
+static const int Bpp[]   = { 24, 32 };
+static const int Scale[] = { 1, 2, 4 };
+
+static const char *AsciiText  = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789abcdefghijklmnopqrstuvwxyz";
+static const char *HangulText = "가나다라마바사아자차카타파하거너더러머버서어저처커터퍼허";
+
+//------------------------------------------------------------------------------
+// 측정 항목
+//------------------------------------------------------------------------------
+typedef struct bench_arg__t {
+	fb_info_t	*fb;
+	ui_grp_t	*ui;
+	int			scale, color;
+	char		*str;
+}	bench_arg_t;
+
+typedef void (*bench_func_t) (bench_arg_t *arg, int n);
+
+//------------------------------------------------------------------------------
+// function prototype define
+//------------------------------------------------------------------------------
+static void		print_usage		(const char *prog);
+static void		parse_opts		(int argc, char *argv[]);
+static __u64	bench_time_us	(void);
+static double	bench_run		(bench_func_t func, bench_arg_t *arg);
+static void		bench_fill_full	(bench_arg_t *arg, int n);
+static void		bench_fill_cell	(bench_arg_t *arg, int n);
+static void		bench_text		(bench_arg_t *arg, int n);
+static void		bench_ui_update	(bench_arg_t *arg, int n);
+static void		bench_ui_printf	(bench_arg_t *arg, int n);
+static int		make_text		(char *buf, const char *src, int c_size, int cnt);
+static void		bench_fb		(FILE *report, int w, int h, int bpp);
+int				main			(int argc, char *argv[]);
+
+//------------------------------------------------------------------------------
+static void print_usage (const char *prog)
+{
+	printf("Usage: %s [-tWHbuv]\n", prog);
+	puts("  -t --time         minimum time per test (ms, default 200)\n"
+		 "  -W --width        framebuffer width  (default 800, 1920, 3840)\n"
+		 "  -H --height       framebuffer height (default 480, 1080, 2160)\n"
+		 "  -b --bpp          bits per pixel 16, 24, 32 (default 24, 32)\n"
+		 "  -u --ui_config    ui config file for ui_update (default default_ui.cfg)\n"
+		 "  -v --verbose      keep library log messages\n"
+	);
+	exit(1);
+}
+
+//------------------------------------------------------------------------------
+static void parse_opts (int argc, char *argv[])
+{
+	while (1) {
+		static const struct option lopts[] = {
+			{ "time"		, 1, 0, 't' },
+			{ "width"		, 1, 0, 'W' },
+			{ "height"		, 1, 0, 'H' },
+			{ "bpp"			, 1, 0, 'b' },
+			{ "ui_config"	, 1, 0, 'u' },
+			{ "verbose"		, 0, 0, 'v' },
+			{ NULL, 0, 0, 0 },
+		};
+		int c;
+
+		c = getopt_long(argc, argv, "t:W:H:b:u:v", lopts, NULL);
+
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 't':	OPT_TIME_mS		= atoi(optarg);	break;
+		case 'W':	OPT_WIDTH		= atoi(optarg);	break;
+		case 'H':	OPT_HEIGHT		= atoi(optarg);	break;
+		case 'b':	OPT_BPP			= atoi(optarg);	break;
+		case 'u':	OPT_UI_CFG_FILE	= optarg;		break;
+		case 'v':	OPT_VERBOSE		= true;			break;
+		default:
+			print_usage(argv[0]);
+			break;
+		}
+	}
+	if (OPT_TIME_mS < 1)									print_usage(argv[0]);
+	if ((OPT_WIDTH < 0) || (OPT_HEIGHT < 0))				print_usage(argv[0]);
+	if ((!OPT_WIDTH) != (!OPT_HEIGHT))						print_usage(argv[0]);
+	if (OPT_BPP && (OPT_BPP != 16) && (OPT_BPP != 24) && (OPT_BPP != 32))
+		print_usage(argv[0]);
+}
+
+//------------------------------------------------------------------------------
+static __u64 bench_time_us (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (__u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//------------------------------------------------------------------------------
+// 최소 측정 시간 이상 반복 실행 (return : 1회 실행 시간 ns)
+//------------------------------------------------------------------------------
+static double bench_run (bench_func_t func, bench_arg_t *arg)
+{
+	__u64 start, elapsed;
+	int n = 1, total = 0;
+
+	/* glyph cache, hangul table 생성 시간은 제외 */
+	func (arg, 1);
+
+	start = bench_time_us ();
+	while ((elapsed = bench_time_us () - start) < (__u64)OPT_TIME_mS * 1000) {
+		func (arg, n);
+		total += n;
+		/* 시간 측정 overhead를 줄이기 위해 반복 횟수를 늘림 */
+		if (n < 1024)
+			n <<= 1;
+	}
+	return (double)elapsed * 1000 / total;
+}
+
+//------------------------------------------------------------------------------
+static void bench_fill_full (bench_arg_t *arg, int n)
+{
+	while (n--) {
+		draw_fill_rect (arg->fb, 0, 0, arg->fb->w, arg->fb->h, arg->color);
+		arg->color ^= COLOR_WHITE;
+	}
+}
+
+//------------------------------------------------------------------------------
+/* ui item 크기의 영역 (64 x 32) */
+#define	CELL_W	64
+#define	CELL_H	32
+
+static void bench_fill_cell (bench_arg_t *arg, int n)
+{
+	int x = 0, y = 0;
+
+	while (n--) {
+		draw_fill_rect (arg->fb, x, y, CELL_W, CELL_H, arg->color);
+		arg->color ^= COLOR_WHITE;
+		if ((x += CELL_W) + CELL_W > arg->fb->w) {
+			x = 0;
+			y = ((y += CELL_H) + CELL_H > arg->fb->h) ? 0 : y;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+static void bench_text (bench_arg_t *arg, int n)
+{
+	while (n--)
+		draw_text (arg->fb, 0, 0, COLOR_WHITE, COLOR_BLACK, arg->scale, arg->str);
+}
+
+//------------------------------------------------------------------------------
+static void bench_ui_update (bench_arg_t *arg, int n)
+{
+	while (n--)
+		ui_update (arg->fb, arg->ui, -1);
+}
+
+//------------------------------------------------------------------------------
+/* 시간 표시 item (server time_display와 같은 형태) */
+#define	UI_PRINTF_ID	2
+
+static void bench_ui_printf (bench_arg_t *arg, int n)
+{
+	while (n--) {
+		ui_set_printf (arg->fb, arg->ui, UI_PRINTF_ID, "%02d:%02d:%02d",
+			(arg->color / 3600) % 24, (arg->color / 60) % 60, arg->color % 60);
+		arg->color++;
+	}
+}
+
+//------------------------------------------------------------------------------
+// src에서 cnt개 문자 복사 (c_size : utf-8 문자 크기)
+//------------------------------------------------------------------------------
+static int make_text (char *buf, const char *src, int c_size, int cnt)
+{
+	int max = strlen (src) / c_size;
+
+	cnt = (cnt > max) ? max : cnt;
+	memcpy (buf, src, cnt * c_size);
+	buf[cnt * c_size] = 0;
+	return cnt;
+}
+
+//------------------------------------------------------------------------------
+static void bench_fb (FILE *report, int w, int h, int bpp)
+{
+	char dev[32], str[TEXT_GLYPH_MAX * UTF8_HANGUL_SIZE + 1];
+	bench_arg_t arg;
+	double ns;
+	int i, cnt, g_w;
+
+	snprintf (dev, sizeof(dev), "mem:%dx%dx%d", w, h, bpp);
+	memset (&arg, 0, sizeof(arg));
+	if ((arg.fb = fb_init (dev)) == NULL) {
+		fprintf (report, "%s : framebuffer init fail!\n", dev);
+		return;
+	}
+	fprintf (report, "%s\n", dev);
+
+	ns = bench_run (bench_fill_full, &arg);
+	fprintf (report, "  fill %4dx%-4d      : %8.3f ns/pixel, %10.3f ms/frame\n",
+			w, h, ns / (w * h), ns / 1000000);
+
+	ns = bench_run (bench_fill_cell, &arg);
+	fprintf (report, "  fill %4dx%-4d      : %8.3f ns/pixel, %10.3f us/rect\n",
+			CELL_W, CELL_H, ns / (CELL_W * CELL_H), ns / 1000);
+
+	/* 화면 폭에 들어가는 문자 수 만큼 한줄 출력 */
+	for (i = 0; i < (int)(sizeof(Scale) / sizeof(Scale[0])); i++) {
+		arg.scale = Scale[i];
+		arg.str   = str;
+
+		g_w = FONT_ASCII_WIDTH * arg.scale;
+		cnt = make_text (str, AsciiText, 1, w / g_w);
+		ns  = bench_run (bench_text, &arg);
+		fprintf (report, "  text ascii  x%d      : %8.3f ns/pixel, %10.0f glyphs/s\n",
+			arg.scale, ns / (cnt * g_w * FONT_HEIGHT * arg.scale), cnt * 1e9 / ns);
+
+		g_w = FONT_HANGUL_WIDTH * arg.scale;
+		cnt = make_text (str, HangulText, UTF8_HANGUL_SIZE, w / g_w);
+		ns  = bench_run (bench_text, &arg);
+		fprintf (report, "  text hangul x%d      : %8.3f ns/pixel, %10.0f glyphs/s\n",
+			arg.scale, ns / (cnt * g_w * FONT_HEIGHT * arg.scale), cnt * 1e9 / ns);
+	}
+
+	if ((arg.ui = ui_init (arg.fb, OPT_UI_CFG_FILE)) == NULL) {
+		fprintf (report, "  %s : ui config not found, ui test skip.\n", OPT_UI_CFG_FILE);
+	} else {
+		ns = bench_run (bench_ui_update, &arg);
+		fprintf (report, "  ui_update(-1)       : %8.3f ns/pixel, %10.3f ms (full repaint)\n",
+				ns / (w * h), ns / 1000000);
+
+		arg.color = 0;
+		ns = bench_run (bench_ui_printf, &arg);
+		fprintf (report, "  ui_set_printf       : %8.3f us/call\n", ns / 1000);
+		ui_close (arg.ui);
+	}
+	fb_close (arg.fb);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+	FILE *report = stdout;
+	int r, b, w, h;
+
+	parse_opts (argc, argv);
+
+	/* library log는 측정에서 제외 (결과는 원래의 stdout으로 출력) */
+	if (!OPT_VERBOSE) {
+		report = fdopen (dup (STDOUT_FILENO), "w");
+		if ((report == NULL) || (freopen ("/dev/null", "w", stdout) == NULL))
+			return 1;
+	}
+
+	fprintf (report, "min time %d ms per test\n", OPT_TIME_mS);
+	for (r = 0; r < (int)(sizeof(Resolution) / sizeof(Resolution[0])); r++) {
+		w = OPT_WIDTH  ? OPT_WIDTH  : Resolution[r][0];
+		h = OPT_HEIGHT ? OPT_HEIGHT : Resolution[r][1];
+
+		for (b = 0; b < (int)(sizeof(Bpp) / sizeof(Bpp[0])); b++) {
+			bench_fb (report, w, h, OPT_BPP ? OPT_BPP : Bpp[b]);
+			/* 지정된 bpp만 한번 측정 */
+			if (OPT_BPP)
+				break;
+		}
+		/* 지정된 해상도만 한번 측정 */
+		if (OPT_WIDTH)
+			break;
+	}
+	fclose (report);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -0,0 +1,649 @@
+//------------------------------------------------------------------------------
+/**
+ * @file uart_bench.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief pty DUT simulator & uart throughput/latency benchmark.
+ *
+ *        pty pair를 만들어 slave는 server의 channel(uart_init, ch_init)에 연결하고
+ *        master에서는 protocol_t(또는 binary frame)로 응답하는 DUT를 simulation 한다.
+ *        실제 server code(rx/tx thread, ptc_event, send_msg_check)를 그대로 사용한다.
+ * @version 0.1
+ * @date 2022-05-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include "typedefs.h"
+#include "lib_fb.h"
+#include "lib_ui.h"
+#include "lib_uart.h"
+#include "server.h"
+
+//------------------------------------------------------------------------------
+#define	SIM_REPLY_MAX		64
+#define	SIM_RX_BUF_SIZE		1024
+#define	SIM_IDLE_mS			10
+/* 모든 command가 완료되지 않으면 round 종료 (error injection시 retry 포함) */
+#define	ROUND_TIMEOUT_mS	60000
+
+//------------------------------------------------------------------------------
+// Default global value
+//------------------------------------------------------------------------------
+int		OPT_CH_COUNT	= 1;
+int		OPT_CMD_COUNT	= 100;
+int		OPT_ROUNDS		= 10;
+int		OPT_WINDOW		= 4;
+/* DUT 응답 지연 (us) */
+int		OPT_LATENCY		= 0;
+int		OPT_JITTER		= 0;
+/* 응답 frame 손상, 'B'usy, 'E'rror 응답 비율 (1/1000) */
+int		OPT_CORRUPT		= 0;
+int		OPT_BUSY		= 0;
+int		OPT_ERROR		= 0;
+/* DUT 최대 baud (0 = baud negotiation 지원안함), verify 응답을 손상시킬 negotiation 수 */
+int		OPT_BAUD		= 0;
+int		OPT_VERIFY		= 0;
+bool	OPT_BIN			= false;
+bool	OPT_VERBOSE		= false;
+
+//------------------------------------------------------------------------------
+/* 전송 예정인 DUT 응답 frame */
+typedef struct sim_reply__t {
+	__u64	due_us;
+	/* 전송 후 변경할 baud (0 = 변경없음) */
+	__u32	baud;
+	int		size;
+	__u8	frame[BIN_FRAME_MAX > sizeof(protocol_t) ? BIN_FRAME_MAX : sizeof(protocol_t)];
+}	sim_reply_t;
+
+typedef struct sim_dut__t {
+	int			fd;
+	pthread_t	thread;
+	bool		run;
+	/* server 'R' 응답 이후 binary frame 사용 */
+	bool		bin_mode;
+	unsigned int	seed;
+
+	/*
+		pty는 baud와 관계없이 data를 전달하므로 server uart의 baud(line)와
+		DUT baud가 다르면 주고받는 frame을 손상시킨다.
+	*/
+	const __u32	*line;
+	__u32		baud;
+	/* COMMIT을 받지 않았거나 KEEPALIVE가 없으면 BAUD_BASE로 복귀할 시간 (us) */
+	bool		commit;
+	__u64		revert_us;
+	int			verify_fail;
+
+	__u8		rx_buf[SIM_RX_BUF_SIZE];
+	int			rx_len;
+
+	sim_reply_t	reply[SIM_REPLY_MAX];
+	int			reply_cnt;
+
+	/* 측정값 */
+	__u64		rx_frames, tx_frames, rx_bytes, tx_bytes;
+}	sim_dut_t;
+
+//------------------------------------------------------------------------------
+// function prototype define
+//------------------------------------------------------------------------------
+static void	print_usage		(const char *prog);
+static void	parse_opts		(int argc, char *argv[]);
+static int	sim_rand		(sim_dut_t *dut, int range);
+static int	sim_frame		(sim_dut_t *dut, char resp, int cmd_id, const char *msg, __u8 *frame);
+static void	sim_reply		(sim_dut_t *dut, char resp, int cmd_id, const char *msg, __u64 due_us);
+static bool	sim_line_ok		(sim_dut_t *dut);
+static void	sim_baud		(sim_dut_t *dut, char cmd, int cmd_id, const char *msg, __u64 due_us);
+static void	sim_command		(sim_dut_t *dut, char cmd, int cmd_id, const char *msg);
+static int	sim_parse		(sim_dut_t *dut);
+static void	sim_flush		(sim_dut_t *dut);
+static void	*sim_thread_func(void *arg);
+static int	sim_open		(sim_dut_t *dut, char *slave, int s_size, const __u32 *line);
+static int	cmp_u32			(const void *a, const void *b);
+static bool	bench_round		(jig_server_t *pserver, sim_dut_t *dut,
+								__u32 *rtt, int *rtt_cnt, __u64 *elapsed_us);
+int			main			(int argc, char *argv[]);
+
+//------------------------------------------------------------------------------
+static void print_usage (const char *prog)
+{
+	printf("Usage: %s [-cnrwljxbeSVBv]\n", prog);
+	puts("  -c --channel      channel count (default 1, max 16)\n"
+		 "  -n --commands     command count per round (default 100, max 127)\n"
+		 "  -r --rounds       round count (default 10)\n"
+		 "  -w --window       in-flight command window (default 4, max 8)\n"
+		 "  -l --latency      DUT reply latency (us, default 0)\n"
+		 "  -j --jitter       DUT reply jitter (+us, default 0)\n"
+		 "  -x --corrupt      corrupted reply frame (1/1000, default 0)\n"
+		 "  -b --busy         'B'usy reply before 'O'kay (1/1000, default 0)\n"
+		 "  -e --error        'E'rror reply instead of 'O'kay (1/1000, default 0)\n"
+		 "  -S --baud         DUT max baud for baud negotiation (default 0 = not supported)\n"
+		 "  -V --verify       corrupt the last verify echo of the first N negotiations (default 0)\n"
+		 "  -B --binary       DUT requests binary frame in ready handshake\n"
+		 "  -v --verbose      keep server log messages\n"
+	);
+	exit(1);
+}
+
+//------------------------------------------------------------------------------
+static void parse_opts (int argc, char *argv[])
+{
+	while (1) {
+		static const struct option lopts[] = {
+			{ "channel"		, 1, 0, 'c' },
+			{ "commands"	, 1, 0, 'n' },
+			{ "rounds"		, 1, 0, 'r' },
+			{ "window"		, 1, 0, 'w' },
+			{ "latency"		, 1, 0, 'l' },
+			{ "jitter"		, 1, 0, 'j' },
+			{ "corrupt"		, 1, 0, 'x' },
+			{ "busy"		, 1, 0, 'b' },
+			{ "error"		, 1, 0, 'e' },
+			{ "baud"		, 1, 0, 'S' },
+			{ "verify"		, 1, 0, 'V' },
+			{ "binary"		, 0, 0, 'B' },
+			{ "verbose"		, 0, 0, 'v' },
+			{ NULL, 0, 0, 0 },
+		};
+		int c;
+
+		c = getopt_long(argc, argv, "c:n:r:w:l:j:x:b:e:S:V:Bv", lopts, NULL);
+
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'c':	OPT_CH_COUNT	= atoi(optarg);	break;
+		case 'n':	OPT_CMD_COUNT	= atoi(optarg);	break;
+		case 'r':	OPT_ROUNDS		= atoi(optarg);	break;
+		case 'w':	OPT_WINDOW		= atoi(optarg);	break;
+		case 'l':	OPT_LATENCY		= atoi(optarg);	break;
+		case 'j':	OPT_JITTER		= atoi(optarg);	break;
+		case 'x':	OPT_CORRUPT		= atoi(optarg);	break;
+		case 'b':	OPT_BUSY		= atoi(optarg);	break;
+		case 'e':	OPT_ERROR		= atoi(optarg);	break;
+		case 'S':	OPT_BAUD		= atoi(optarg);	break;
+		case 'V':	OPT_VERIFY		= atoi(optarg);	break;
+		case 'B':	OPT_BIN			= true;			break;
+		case 'v':	OPT_VERBOSE		= true;			break;
+		default:
+			print_usage(argv[0]);
+			break;
+		}
+	}
+	if ((OPT_CH_COUNT  < 1) || (OPT_CH_COUNT  > CH_COUNT_MAX))		print_usage(argv[0]);
+	if ((OPT_CMD_COUNT < 1) || (OPT_CMD_COUNT > 127))				print_usage(argv[0]);
+	if ((OPT_WINDOW    < 1) || (OPT_WINDOW    > CMD_WINDOW_MAX))	print_usage(argv[0]);
+	if (OPT_ROUNDS < 1)												print_usage(argv[0]);
+	if (OPT_BAUD && (OPT_BAUD <= BAUD_BASE))						print_usage(argv[0]);
+}
+
+//------------------------------------------------------------------------------
+static int sim_rand (sim_dut_t *dut, int range)
+{
+	return range ? (rand_r (&dut->seed) % range) : 0;
+}
+
+//------------------------------------------------------------------------------
+// DUT 응답 frame 생성 (return : frame 크기)
+//------------------------------------------------------------------------------
+static int sim_frame (sim_dut_t *dut, char resp, int cmd_id, const char *msg, __u8 *frame)
+{
+	int m_size = strlen(msg), pos;
+	__u16 crc;
+
+	if (dut->bin_mode) {
+		m_size = (m_size > BIN_PAYLOAD_MAX) ? BIN_PAYLOAD_MAX : m_size;
+		frame[0] = BIN_HEAD;
+		pos  = 1 + varint_put (&frame[1], m_size + 3);
+		frame[pos++] = resp;
+		frame[pos++] = cmd_id;
+		frame[pos++] = eBIN_TYPE_TEXT;
+		memcpy (&frame[pos], msg, m_size);
+		pos += m_size;
+		crc = crc16 (&frame[1], pos - 1);
+		frame[pos++] = crc & 0xFF;
+		frame[pos++] = crc >> 8;
+		return pos;
+	} else {
+		protocol_t *p = (protocol_t *)frame;
+
+		memset (p, 0, sizeof(protocol_t));
+		p->head = '@';	p->tail = '#';
+		p->cmd  = resp;
+		pos = sprintf ((char *)p->data, "%03d,", cmd_id);
+		m_size = (m_size > (PROTOCOL_DATA_SIZE - pos)) ? (PROTOCOL_DATA_SIZE - pos) : m_size;
+		memcpy (&p->data[pos], msg, m_size);
+		return sizeof(protocol_t);
+	}
+}
+
+//------------------------------------------------------------------------------
+static void sim_reply (sim_dut_t *dut, char resp, int cmd_id, const char *msg, __u64 due_us)
+{
+	sim_reply_t *r;
+
+	if (dut->reply_cnt >= SIM_REPLY_MAX) {
+		err ("reply queue full! (cmd_id = %d)\n", cmd_id);
+		return;
+	}
+	r = &dut->reply[dut->reply_cnt++];
+	r->due_us = due_us;
+	r->baud   = 0;
+	r->size   = sim_frame (dut, resp, cmd_id, msg, r->frame);
+
+	/* error injection : frame 끝(tail or crc)을 손상시킨다. */
+	if (sim_rand (dut, 1000) < OPT_CORRUPT)
+		r->frame[r->size - 1] ^= 0x5A;
+}
+
+//------------------------------------------------------------------------------
+// server uart와 DUT의 baud가 같은지 확인
+//------------------------------------------------------------------------------
+static bool sim_line_ok (sim_dut_t *dut)
+{
+	return (__atomic_load_n (dut->line, __ATOMIC_RELAXED) == dut->baud) ? true : false;
+}
+
+//------------------------------------------------------------------------------
+// baud negotiation (server.h 참조)
+//------------------------------------------------------------------------------
+static void sim_baud (sim_dut_t *dut, char cmd, int cmd_id, const char *msg, __u64 due_us)
+{
+	__u32 baud;
+
+	if (cmd == 'S') {
+		baud = strtoul (msg, NULL, 10);
+		if (!OPT_BAUD || (baud <= BAUD_BASE) || (baud > (__u32)OPT_BAUD)) {
+			sim_reply (dut, 'E', cmd_id, msg, due_us);
+			return;
+		}
+		/* 'A' 응답을 전송한 후 baud 변경 */
+		sim_reply (dut, 'A', cmd_id, msg, due_us);
+		dut->reply[dut->reply_cnt - 1].baud = baud;
+		return;
+	}
+
+	if (!strcmp (msg, "COMMIT")) {
+		dut->commit    = true;
+		dut->revert_us = time_us() + BAUD_TIMEOUT_mS * 1000ULL;
+	}
+	else if (!strcmp (msg, "KEEPALIVE")) {
+		if (dut->commit)
+			dut->revert_us = time_us() + BAUD_TIMEOUT_mS * 1000ULL;
+	}
+	/* error injection : 마지막 verify 응답 손상 (DUT는 모든 verify frame을 받음) */
+	else if (dut->verify_fail && !strncmp (msg, "VERIFY,", strlen("VERIFY,")) &&
+			(atoi (&msg[strlen("VERIFY,")]) == (BAUD_VERIFY_COUNT - 1))) {
+		dut->verify_fail--;
+		sim_reply (dut, 'V', cmd_id, "VERIFY,X", due_us);
+		return;
+	}
+	sim_reply (dut, 'V', cmd_id, msg, due_us);
+}
+
+//------------------------------------------------------------------------------
+static void sim_command (sim_dut_t *dut, char cmd, int cmd_id, const char *msg)
+{
+	__u64 due = time_us() + OPT_LATENCY + sim_rand (dut, OPT_JITTER + 1);
+
+	switch (cmd) {
+		case 'C':
+			if (sim_rand (dut, 1000) < OPT_BUSY) {
+				sim_reply (dut, 'B', cmd_id, "BUSY", due);
+				due += OPT_LATENCY + sim_rand (dut, OPT_JITTER + 1);
+			}
+			if (sim_rand (dut, 1000) < OPT_ERROR)
+				sim_reply (dut, 'E', cmd_id, "ERROR", due);
+			else
+				sim_reply (dut, 'O', cmd_id, "OKAY", due);
+		break;
+		/* server의 ready 응답 : 선택된 frame 형식 사용 */
+		case 'R':
+			dut->bin_mode = strstr (msg, "BIN") ? true : false;
+		break;
+		case 'S':	case 'V':
+			sim_baud (dut, cmd, cmd_id, msg, due);
+		break;
+		default :
+		break;
+	}
+}
+
+//------------------------------------------------------------------------------
+// rx buffer에서 server frame을 찾아 처리 (return : 처리한 frame 수)
+//------------------------------------------------------------------------------
+static int sim_parse (sim_dut_t *dut)
+{
+	__u8 *d = dut->rx_buf, *p;
+	char msg[PROTOCOL_DATA_SIZE + 1];
+	int remain = dut->rx_len, f_size, v_size, cnt = 0;
+	__u32 len;
+
+	while (remain > 0) {
+		if (d[0] == '@') {
+			protocol_t *f = (protocol_t *)d;
+
+			if (remain < (int)sizeof(protocol_t))
+				break;
+			f_size = sizeof(protocol_t);
+			if (f->tail == '#') {
+				memcpy (msg, f->data, PROTOCOL_DATA_SIZE);
+				msg[PROTOCOL_DATA_SIZE] = 0;
+				sim_command (dut, f->cmd, atoi(msg), &msg[4]);
+				cnt++;
+			} else
+				f_size = 1;
+		}
+		else if (d[0] == BIN_HEAD) {
+			if ((v_size = varint_get (&d[1], remain - 1, &len)) == 0)
+				break;
+			f_size = 1 + v_size + len + 2;
+			if ((v_size < 0) || (len < 3) || (len > (BIN_PAYLOAD_MAX + 3)))
+				f_size = 1;
+			else if (remain < f_size)
+				break;
+			else if (crc16 (&d[1], f_size - 3) ==
+						(d[f_size - 2] | (d[f_size - 1] << 8))) {
+				p = &d[1 + v_size];
+				memcpy (msg, &p[3], len - 3);
+				msg[len - 3] = 0;
+				sim_command (dut, p[0], p[1], msg);
+				cnt++;
+			} else
+				f_size = 1;
+		}
+		else
+			f_size = 1;
+
+		d += f_size;	remain -= f_size;
+	}
+	memmove (dut->rx_buf, d, remain);
+	dut->rx_len = remain;
+	return cnt;
+}
+
+//------------------------------------------------------------------------------
+// 전송 시간이 된 응답 frame 전송
+//------------------------------------------------------------------------------
+static void sim_flush (sim_dut_t *dut)
+{
+	__u64 now = time_us();
+	int i = 0;
+
+	while (i < dut->reply_cnt) {
+		sim_reply_t *r = &dut->reply[i];
+
+		if (r->due_us > now) {
+			i++;
+			continue;
+		}
+		/* baud가 다르면 server에서는 잘못된 data로 수신 */
+		if (!sim_line_ok (dut))
+			memset (r->frame, 0, r->size);
+		if (write (dut->fd, r->frame, r->size) == r->size) {
+			dut->tx_frames++;
+			dut->tx_bytes += r->size;
+		} else
+			err ("pty write error! (%s)\n", strerror(errno));
+
+		if (r->baud) {
+			dut->baud      = r->baud;
+			dut->commit    = false;
+			dut->revert_us = now + BAUD_TIMEOUT_mS * 1000ULL;
+		}
+
+		/* 같은 시간의 응답은 요청 순서대로 전송 (verify 응답은 순서를 확인함) */
+		memmove (r, r + 1, sizeof(sim_reply_t) * (--dut->reply_cnt - i));
+	}
+}
+
+//------------------------------------------------------------------------------
+static void *sim_thread_func (void *arg)
+{
+	sim_dut_t *dut = (sim_dut_t *)arg;
+	struct pollfd pfd;
+	struct timespec ts;
+	__u64 now, wait_us;
+	int i, len;
+
+	pfd.fd     = dut->fd;
+	pfd.events = POLLIN;
+
+	/* DUT boot : ready 전송 */
+	if (OPT_BIN || OPT_BAUD) {
+		char caps[32];
+
+		sprintf (caps, "%s,BAUD=%d", OPT_BIN ? "BIN" : "ASCII", OPT_BAUD);
+		sim_reply (dut, 'R', 0, caps, 0);
+	}
+
+	while (__atomic_load_n (&dut->run, __ATOMIC_ACQUIRE)) {
+		sim_flush (dut);
+
+		/* COMMIT 또는 KEEPALIVE가 없으면 BAUD_BASE로 복귀 */
+		now = time_us();
+		if ((dut->baud != BAUD_BASE) && (now >= dut->revert_us)) {
+			dut->baud   = BAUD_BASE;
+			dut->commit = false;
+		}
+
+		/* 다음 응답 시간까지 대기 (us 단위 지연을 위하여 ppoll 사용) */
+		wait_us = SIM_IDLE_mS * 1000;
+		if ((dut->baud != BAUD_BASE) && ((dut->revert_us - now) < wait_us))
+			wait_us = dut->revert_us - now;
+		for (i = 0; i < dut->reply_cnt; i++) {
+			if (dut->reply[i].due_us <= now)
+				wait_us = 0;
+			else if ((dut->reply[i].due_us - now) < wait_us)
+				wait_us = dut->reply[i].due_us - now;
+		}
+		ts.tv_sec  = wait_us / 1000000;
+		ts.tv_nsec = (wait_us % 1000000) * 1000;
+
+		if (ppoll (&pfd, 1, &ts, NULL) <= 0)
+			continue;
+
+		while ((len = read (dut->fd, &dut->rx_buf[dut->rx_len],
+							SIM_RX_BUF_SIZE - dut->rx_len)) > 0) {
+			/* baud가 다르면 frame을 수신할 수 없음 */
+			if (!sim_line_ok (dut))
+				continue;
+			dut->rx_bytes  += len;
+			dut->rx_len    += len;
+			dut->rx_frames += sim_parse (dut);
+		}
+	}
+	return NULL;
+}
+
+//------------------------------------------------------------------------------
+// pty pair 생성 (return : master fd, slave는 server channel에서 open)
+//------------------------------------------------------------------------------
+static int sim_open (sim_dut_t *dut, char *slave, int s_size, const __u32 *line)
+{
+	int fd;
+
+	if ((fd = posix_openpt (O_RDWR | O_NOCTTY | O_NONBLOCK)) < 0)
+		return -1;
+	if (grantpt (fd) || unlockpt (fd) || ptsname_r (fd, slave, s_size)) {
+		close (fd);
+		return -1;
+	}
+	memset (dut, 0, sizeof(sim_dut_t));
+	dut->fd   = fd;
+	dut->seed = fd * 7919 + (unsigned int)time_us();
+	dut->line = line;
+	dut->baud = BAUD_BASE;
+	dut->verify_fail = OPT_VERIFY;
+	return fd;
+}
+
+//------------------------------------------------------------------------------
+static int cmp_u32 (const void *a, const void *b)
+{
+	__u32 x = *(const __u32 *)a, y = *(const __u32 *)b;
+
+	return (x > y) - (x < y);
+}
+
+//------------------------------------------------------------------------------
+// 1 round : 모든 channel을 새로 만들고 모든 command가 완료될 때까지 측정
+//------------------------------------------------------------------------------
+static bool bench_round (jig_server_t *pserver, sim_dut_t *dut,
+						__u32 *rtt, int *rtt_cnt, __u64 *elapsed_us)
+{
+	jig_ch_t *pch;
+	__u64 start, timeout;
+	bool done = false;
+	int ch, i;
+
+	for (ch = 0; ch < pserver->ch_cnt; ch++) {
+		pch = &pserver->ch[ch];
+		memset (pch, 0, sizeof(jig_ch_t));
+		pch->id = ch;
+		/* simulator는 ch_init 전부터 server uart baud(line)를 참조 */
+		pch->baud.rate = BAUD_BASE;
+
+		if (sim_open (&dut[ch], pch->uart_dev, sizeof(pch->uart_dev), &pch->baud.rate) < 0) {
+			err ("pty open error! (%s)\n", strerror(errno));
+			return false;
+		}
+		/* uart_init은 rx buffer를 flush 하므로 simulator보다 먼저 */
+		if ((pch->puart = uart_init (pch->uart_dev, B115200)) == NULL)
+			return false;
+
+		dut[ch].run = true;
+		pthread_create (&dut[ch].thread, NULL, sim_thread_func, &dut[ch]);
+	}
+
+	start = time_us();
+	for (ch = 0; ch < pserver->ch_cnt; ch++) {
+		if (!ch_init (pserver, &pserver->ch[ch])) {
+			err ("ch %d : channel init fail!\n", ch);
+			return false;
+		}
+	}
+
+	/* cmd_done은 channel thread에서 변경된다. */
+	timeout = start + ROUND_TIMEOUT_mS * 1000ULL;
+	while (!done && (time_us() < timeout)) {
+		usleep (1000);
+		for (done = true, ch = 0; ch < pserver->ch_cnt; ch++)
+			if (__atomic_load_n (&pserver->ch[ch].cmd_done, __ATOMIC_ACQUIRE) < pserver->cmd_cnt)
+				done = false;
+	}
+	*elapsed_us += time_us() - start;
+
+	for (ch = 0; ch < pserver->ch_cnt; ch++) {
+		pch = &pserver->ch[ch];
+		ch_close (pch);
+
+		/* server와 DUT의 baud가 다르면 이후 통신 불가 */
+		if (pch->baud.rate != dut[ch].baud) {
+			err ("ch %d : baud mismatch! (server %u, DUT %u)\n",
+					ch, pch->baud.rate, dut[ch].baud);
+			done = false;
+		}
+
+		__atomic_store_n (&dut[ch].run, false, __ATOMIC_RELEASE);
+		pthread_join (dut[ch].thread, NULL);
+
+		uart_close (pch->puart);
+		close (dut[ch].fd);
+
+		for (i = 0; i < pserver->cmd_cnt; i++)
+			if (pch->cmd_result[i])
+				rtt[(*rtt_cnt)++] = pch->cmd_rtt[i];
+	}
+	if (!done)
+		err ("round fail! (timeout %d sec)\n", ROUND_TIMEOUT_mS / 1000);
+	return done;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+	static jig_server_t server;
+	static sim_dut_t dut[CH_COUNT_MAX];
+	jig_server_t *pserver = &server;
+	__u64 elapsed_us = 0, rx_frames = 0, tx_frames = 0, rx_bytes = 0, tx_bytes = 0;
+	__u32 *rtt, retry = 0, busy = 0, error = 0;
+	int rtt_cnt = 0, r, ch, i;
+	double sec;
+	FILE *report = stdout;
+
+	parse_opts (argc, argv);
+
+	pserver->ch_cnt     = OPT_CH_COUNT;
+	pserver->cmd_window = OPT_WINDOW;
+	pserver->baud_max   = OPT_BAUD ? OPT_BAUD : BAUD_BASE;
+	pserver->cmd_cnt    = OPT_CMD_COUNT;
+	for (i = 0; i < pserver->cmd_cnt; i++)
+		snprintf (pserver->cmds[i], PROTOCOL_DATA_SIZE, "BENCH,%d", i);
+
+	rtt = (__u32 *)malloc (sizeof(__u32) * OPT_ROUNDS * OPT_CH_COUNT * OPT_CMD_COUNT);
+	if (rtt == NULL)
+		return 1;
+
+	/* server의 frame 단위 log는 측정에서 제외 (결과는 원래의 stdout으로 출력) */
+	if (!OPT_VERBOSE) {
+		report = fdopen (dup (STDOUT_FILENO), "w");
+		if ((report == NULL) || (freopen ("/dev/null", "w", stdout) == NULL))
+			return 1;
+	}
+
+	for (r = 0; r < OPT_ROUNDS; r++) {
+		if (!bench_round (pserver, dut, rtt, &rtt_cnt, &elapsed_us))
+			break;
+
+		for (ch = 0; ch < pserver->ch_cnt; ch++) {
+			rx_frames += dut[ch].rx_frames;	tx_frames += dut[ch].tx_frames;
+			rx_bytes  += dut[ch].rx_bytes;	tx_bytes  += dut[ch].tx_bytes;
+			retry += pserver->ch[ch].result.retry_cnt;
+			busy  += pserver->ch[ch].result.busy_cnt;
+			error += pserver->ch[ch].result.error_cnt;
+		}
+	}
+	if (!rtt_cnt || !elapsed_us) {
+		fprintf (report, "no result.\n");
+		return 1;
+	}
+	qsort (rtt, rtt_cnt, sizeof(__u32), cmp_u32);
+	sec = elapsed_us / 1000000.0;
+
+	fprintf (report, "channel %d, window %d, frame %s, latency %d(+%d) us, "
+			"corrupt/busy/error %d/%d/%d per mille\n",
+			OPT_CH_COUNT, OPT_WINDOW, OPT_BIN ? "BIN" : "ASCII",
+			OPT_LATENCY, OPT_JITTER, OPT_CORRUPT, OPT_BUSY, OPT_ERROR);
+	fprintf (report, "rounds     : %d, commands %d, elapsed %.3f sec\n", r, rtt_cnt, sec);
+	fprintf (report, "commands/s : %.0f\n", rtt_cnt / sec);
+	fprintf (report, "frames/s   : %.0f (server tx %llu, rx %llu)\n",
+			(rx_frames + tx_frames) / sec, rx_frames, tx_frames);
+	fprintf (report, "bytes/s    : %.0f (server tx %llu, rx %llu)\n",
+			(rx_bytes + tx_bytes) / sec, rx_bytes, tx_bytes);
+	fprintf (report, "rtt (us)   : p50 %u, p99 %u, max %u\n",
+			rtt[rtt_cnt / 2], rtt[(rtt_cnt * 99) / 100], rtt[rtt_cnt - 1]);
+	fprintf (report, "retry %u, busy %u, error %u\n", retry, busy, error);
+	fclose (report);
+	free (rtt);
+
+	return (r == OPT_ROUNDS) ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
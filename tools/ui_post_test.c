@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+/**
+ * @file ui_post_test.c
+ * @author charles-park (charles.park@hardkernel.com)
+ * @brief ui_post_str coalescing test.
+ *
+ *        같은 frame에 합쳐진 ui_post_str 요청의 결과 화면이
+ *        ui_set_str을 순서대로 호출한 화면과 같은지 확인한다.
+ *        (memory framebuffer, 0 = 성공)
+ * @version 0.1
+ * @date 2022-05-11
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+//------------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "typedefs.h"
+#include "lib_fb.h"
+#include "lib_ui.h"
+
+//------------------------------------------------------------------------------
+#define	TEST_FB_DEV			"mem:800x480x32"
+#define	TEST_UI_CFG_FILE	"default_ui.cfg"
+#define	TEST_ITEM_ID		1
+#define	TEST_CALL_MAX		4
+
+/* render thread frame 간격 (같은 frame 안에서 요청이 합쳐지도록 길게 설정) */
+#define	TEST_RENDER_FPS		5
+
+//------------------------------------------------------------------------------
+// ui_set_str / ui_post_str 인자 (str == NULL 이면 끝)
+//------------------------------------------------------------------------------
+typedef struct test_call__t {
+	int			x, y, scale, font;
+	const char	*str;
+}	test_call_t;
+
+typedef struct test_case__t {
+	const char	*name;
+	test_call_t	call[TEST_CALL_MAX];
+}	test_case_t;
+
+static const test_case_t TestCase[] = {
+	{ "move, text only", {
+		{ 10,  5,  2, -1, "12:34"    },
+		{  0,  0,  0,  0, "12:34:56" },
+	}},
+	{ "auto, text only", {
+		{ -1, -1, -1, -1, "1"        },
+		{  0,  0,  0,  0, "1234567"  },
+	}},
+	{ "text only, move", {
+		{  0,  0,  0,  0, "abc"      },
+		{ 20,  4,  3,  0, "abc"      },
+	}},
+	{ "move, text, text", {
+		{ 30,  2,  1, -1, "A"        },
+		{  0,  0,  0,  0, "ABCD"     },
+		{  0,  0,  0,  0, "AB"       },
+	}},
+	{ "auto, text, auto", {
+		{ -1, -1, -1, -1, "가나"     },
+		{  0,  0,  0,  0, "abc"      },
+		{ -1, -1, -1, -1, "x"        },
+	}},
+};
+
+//------------------------------------------------------------------------------
+static bool run_case (FILE *report, const test_case_t *tc)
+{
+	fb_info_t *fb_set = NULL, *fb_post = NULL;
+	ui_grp_t *ui_set = NULL, *ui_post = NULL;
+	const test_call_t *c;
+	bool pass = false;
+	int i;
+
+	fb_set  = fb_init (TEST_FB_DEV);
+	fb_post = fb_init (TEST_FB_DEV);
+	if ((fb_set == NULL) || (fb_post == NULL))
+		goto out;
+
+	ui_set  = ui_init (fb_set,  TEST_UI_CFG_FILE);
+	ui_post = ui_init (fb_post, TEST_UI_CFG_FILE);
+	if ((ui_set == NULL) || (ui_post == NULL) ||
+		!ui_render_start (fb_post, ui_post, TEST_RENDER_FPS))
+		goto out;
+
+	/* 첫 frame을 그린 후에는 frame 간격 동안 들어온 요청이 합쳐진다. */
+	ui_update (fb_set, ui_set, TEST_ITEM_ID);
+	ui_post_update (ui_post, TEST_ITEM_ID);
+	usleep (20000);
+
+	for (i = 0, c = tc->call; (i < TEST_CALL_MAX) && c->str; i++, c++) {
+		ui_set_str  (fb_set, ui_set, TEST_ITEM_ID,
+						c->x, c->y, c->scale, c->font, "%s", c->str);
+		ui_post_str (ui_post, TEST_ITEM_ID,
+						c->x, c->y, c->scale, c->font, "%s", c->str);
+	}
+	/* ui_close는 대기중인 요청을 모두 그린 후 render thread를 종료 */
+	ui_close (ui_post);	ui_post = NULL;
+
+	pass = !memcmp (fb_set->data, fb_post->data, fb_set->h * fb_set->stride);
+out:
+	fprintf (report, "%-20s : %s\n", tc->name, pass ? "pass" : "FAIL");
+	if (ui_post)	ui_close (ui_post);
+	if (ui_set)		ui_close (ui_set);
+	if (fb_post)	fb_close (fb_post);
+	if (fb_set)		fb_close (fb_set);
+	return pass;
+}
+
+//------------------------------------------------------------------------------
+int main (void)
+{
+	FILE *report;
+	int i, fail = 0;
+
+	/* library log는 제외 (결과는 원래의 stdout으로 출력) */
+	report = fdopen (dup (STDOUT_FILENO), "w");
+	if ((report == NULL) || (freopen ("/dev/null", "w", stdout) == NULL))
+		return 1;
+
+	for (i = 0; i < (int)(sizeof(TestCase) / sizeof(TestCase[0])); i++)
+		if (!run_case (report, &TestCase[i]))
+			fail++;
+
+	fprintf (report, "%d / %d pass\n", i - fail, i);
+	fclose (report);
+	return fail ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
@@ -30,6 +30,7 @@ typedef unsigned char   __u8;
 typedef unsigned short  __u16;
 typedef unsigned int    __u32;
 typedef unsigned long   __ul32;
+typedef unsigned long long  __u64;
 
 typedef signed char     __s8;
 typedef signed short    __s16;